@@ -7,6 +7,8 @@
 #include "threads/io.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -71,7 +73,8 @@ struct channel {
 	struct lock lock;           /* Must acquire to access the controller. */
 	bool expecting_interrupt;   /* True if an interrupt is expected, false if
 								   any interrupt would be spurious. */
-	struct semaphore completion_wait;   /* Up'd by interrupt handler. */
+	struct semaphore completion_wait;   /* Up'd by completion_work. */
+	struct work completion_work;        /* Queued by interrupt handler. */
 
 	struct disk devices[2];     /* The devices on this channel. */
 };
@@ -95,6 +98,7 @@ static void select_device (const struct disk *);
 static void select_device_wait (const struct disk *);
 
 static void interrupt_handler (struct intr_frame *);
+static void complete_command (struct work *);
 
 /* Initialize the disk subsystem and detect disks. */
 void
@@ -122,6 +126,7 @@ disk_init (void) {
 		lock_init (&c->lock);
 		c->expecting_interrupt = false;
 		sema_init (&c->completion_wait, 0);
+		work_init (&c->completion_work, complete_command, c);
 
 		/* Initialize devices. */
 		for (dev_no = 0; dev_no < 2; dev_no++) {
@@ -220,6 +225,7 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
 		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
 	input_sector (c, buffer);
 	d->read_cnt++;
+	thread_current ()->disk_reads++;
 	lock_release (&c->lock);
 }
 
@@ -244,6 +250,7 @@ disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
 	output_sector (c, buffer);
 	sema_down (&c->completion_wait);
 	d->write_cnt++;
+	thread_current ()->disk_writes++;
 	lock_release (&c->lock);
 }
 
@@ -517,7 +524,7 @@ interrupt_handler (struct intr_frame *f) {
 		if (f->vec_no == c->irq) {
 			if (c->expecting_interrupt) {
 				inb (reg_status (c));               /* Acknowledge interrupt. */
-				sema_up (&c->completion_wait);      /* Wake up waiter. */
+				work_queue (&system_wq, &c->completion_work);
 			} else
 				printf ("%s: unexpected interrupt\n", c->name);
 			return;
@@ -526,4 +533,11 @@ interrupt_handler (struct intr_frame *f) {
 	NOT_REACHED ();
 }
 
+/* Wakes up the thread waiting for the command on the channel in
+   W->aux to complete.  Queued by the interrupt handler. */
+static void
+complete_command (struct work *w) {
+	struct channel *c = w->aux;
 
+	sema_up (&c->completion_wait);
+}
@@ -7,6 +7,8 @@
 #include "threads/io.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "intrinsic.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -17,38 +19,102 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
+/* 8254 input frequency, in Hz. */
+#define PIT_HZ 1193180
+
+/* PIT input clocks per timer tick, rounded to nearest. */
+#define TICK_CLOCKS ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Shortest one-shot interval we program, about 50 us, so that a
+   burst of close deadlines cannot turn into an interrupt storm. */
+#define MIN_CLOCKS 60
+
+/* -tickless: Program the PIT one interrupt at a time instead of
+   periodically?  Sleep deadlines are kept in PIT input clocks
+   ("timer clocks") either way; in periodic mode the clock just
+   advances by TICK_CLOCKS on every tick. */
+bool timer_tickless;
+
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* One-shot state, used only with -tickless. */
+static int64_t pit_clock;       /* Timer clocks when counter 0 was armed. */
+static uint16_t pit_armed;      /* Count loaded into counter 0. */
+static int64_t pit_expiry;      /* Timer clocks when it will expire. */
+
+/* Is the idle thread running? */
+static bool in_idle;
+
+/* Statistics. */
+static long long timer_intrs;   /* # of timer interrupts. */
+static long long idle_intrs;    /* # of those taken while idle. */
+static long long hires_sleeps;  /* # of sub-tick sleeps. */
+static int64_t hires_late;      /* Total timer clocks they overslept. */
+static int64_t hires_late_max;  /* Most timer clocks one overslept. */
+
+/* Most TSC cycles spent waking sleepers with interrupts off in
+   one batch. */
+static uint64_t awake_max_cycles;
+
+/* Wakes sleepers.  The timer interrupt only queues it, so that
+   waking many sleepers at once does not keep interrupts off for
+   long; it wakes them AWAKE_BATCH at a time. */
+static struct work awake_work;
+static void awake_work_func (struct work *);
+#define AWAKE_BATCH 16
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Number of TSC cycles per second.
+   Initialized by timer_calibrate(). */
+static uint64_t tsc_hz;
+
+/* Timer ticks over which timer_calibrate() counts TSC cycles. */
+#define TSC_CALIBRATE_TICKS 10
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
+static void clock_sleep (int64_t clocks);
+static int64_t clock_now (void);
+static int64_t next_event (int64_t now);
+static void pit_load (uint16_t count);
+static int64_t pit_elapsed (void);
+static void pit_arm (int64_t deadline);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
-   corresponding interrupt. */
+   corresponding interrupt.  With -tickless, only the first
+   interrupt is set up here; each one then programs the next. */
 void
 timer_init (void) {
-	/* 8254 input frequency divided by TIMER_FREQ, rounded to
-	   nearest. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+	if (timer_tickless) {
+		pit_clock = 0;
+		pit_expiry = TICK_CLOCKS;
+		pit_load (TICK_CLOCKS);
+	} else {
+		uint16_t count = TICK_CLOCKS;
 
-	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
-	outb (0x40, count & 0xff);
-	outb (0x40, count >> 8);
+		outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
+		outb (0x40, count & 0xff);
+		outb (0x40, count >> 8);
+	}
 
+	work_init (&awake_work, awake_work_func, NULL);
 	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
 
-/* Calibrates loops_per_tick, used to implement brief delays. */
+/* Calibrates loops_per_tick, used to implement brief delays,
+   and tsc_hz, used to convert cycle counts into time. */
 void
 timer_calibrate (void) {
 	unsigned high_bit, test_bit;
+	int64_t start;
+	uint64_t tsc;
 
 	ASSERT (intr_get_level () == INTR_ON);
 	printf ("Calibrating timer...  ");
@@ -67,7 +133,34 @@ timer_calibrate (void) {
 		if (!too_many_loops (high_bit | test_bit))
 			loops_per_tick |= test_bit;
 
-	printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+	/* Count TSC cycles from one tick edge to another. */
+	start = timer_ticks ();
+	while (timer_ticks () == start)
+		continue;
+	tsc = rdtsc ();
+	start = timer_ticks ();
+	while (timer_ticks () < start + TSC_CALIBRATE_TICKS)
+		continue;
+	tsc_hz = (rdtsc () - tsc) * TIMER_FREQ / TSC_CALIBRATE_TICKS;
+
+	printf ("%'"PRIu64" loops/s, %'"PRIu64" TSC cycles/s.\n",
+			(uint64_t) loops_per_tick * TIMER_FREQ, tsc_hz);
+}
+
+/* Returns the number of TSC cycles per second. */
+uint64_t
+timer_tsc_hz (void) {
+	return tsc_hz;
+}
+
+/* Converts CYCLES, a difference between two rdtsc() values, into
+   nanoseconds.  Returns 0 before timer_calibrate() has run. */
+uint64_t
+timer_cycles_to_ns (uint64_t cycles) {
+	if (tsc_hz == 0)
+		return 0;
+	return cycles / tsc_hz * 1000000000
+		+ cycles % tsc_hz * 1000000000 / tsc_hz;
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -96,7 +189,7 @@ timer_sleep (int64_t ticks) {
 	// while (timer_elapsed (start) < ticks)
 	// 	thread_yield ();
   if(timer_elapsed(start) < ticks)
-    thread_sleep(start + ticks);
+    thread_sleep((start + ticks) * TICK_CLOCKS);
 }
 
 /* Suspends execution for approximately MS milliseconds. */
@@ -121,19 +214,109 @@ timer_nsleep (int64_t ns) {
 void
 timer_print_stats (void) {
 	printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+	printf ("Timer: %lld interrupts, %lld while idle\n",
+			timer_intrs, idle_intrs);
+	if (hires_sleeps > 0)
+		printf ("Timer: %lld sub-tick sleeps, overslept %"PRId64" us on "
+				"average, %"PRId64" us at most\n", hires_sleeps,
+				hires_late * 1000000 / PIT_HZ / hires_sleeps,
+				hires_late_max * 1000000 / PIT_HZ);
+}
+
+/* Called by the idle thread, with interrupts off, just before it
+   halts the CPU.  With -tickless, the next timer interrupt is
+   put off until the earliest sleeper is due.  Under the MLFQS
+   the idle thread keeps ticking, because the load average must
+   be sampled every second. */
+void
+timer_idle_enter (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	in_idle = true;
+	if (timer_tickless && !thread_mlfqs)
+		pit_arm (get_next_tick_to_awake ());
+}
+
+/* Called by the scheduler, with interrupts off, when it switches
+   away from the idle thread.  Restarts the per-tick interrupt
+   and returns the number of timer ticks that went by without
+   one, all of which were spent idle. */
+int64_t
+timer_idle_exit (void) {
+	int64_t skipped = 0;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	in_idle = false;
+	if (timer_tickless && !thread_mlfqs) {
+		int64_t now = clock_now ();
+
+		skipped = now / TICK_CLOCKS - ticks;
+		ticks += skipped;
+		pit_arm (next_event (now));
+	}
+	return skipped;
 }
 
-/* Timer interrupt handler. */
+/* Returns the most TSC cycles spent waking up sleeping threads
+   with interrupts off in one go. */
+uint64_t
+timer_awake_max_cycles (void) {
+	return awake_max_cycles;
+}
+
+/* Timer interrupt handler.  With -tickless, this may cover more
+   than one tick, or none at all if it was programmed for a
+   sub-tick deadline. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED) {
-	ticks++;
-	thread_tick ();
+	int64_t now;
+
+	timer_intrs++;
+	if (in_idle)
+		idle_intrs++;
+
+	if (timer_tickless) {
+		now = clock_now ();
+		while (ticks < now / TICK_CLOCKS) {
+			ticks++;
+			thread_tick ();
+		}
+	} else {
+		ticks++;
+		thread_tick ();
+		now = ticks * TICK_CLOCKS;
+	}
+
   /* 매 tick마다 sleep queue에서 깨어날 thread가 있는지 확인하여,
 깨우는 함수를 호출하도록 한다. */
-  int64_t next_tick_to_awake = get_next_tick_to_awake();
-  if (ticks >= next_tick_to_awake){
-    thread_awake(ticks);
-  }
+	if (now >= get_next_tick_to_awake ())
+		work_queue (&system_wq, &awake_work);
+
+	if (timer_tickless)
+		pit_arm (next_event (now));
+}
+
+/* Wakes up every sleeping thread that is due, AWAKE_BATCH at a
+   time, turning interrupts back on between batches.  Normally
+   runs on the system workqueue, but runs inside the timer
+   interrupt until that has a worker. */
+static void
+awake_work_func (struct work *w UNUSED) {
+	int woken;
+
+	do {
+		enum intr_level old_level = intr_disable ();
+		int64_t now = clock_now ();
+		uint64_t start = rdtsc ();
+		uint64_t cycles;
+
+		woken = thread_awake (now, AWAKE_BATCH);
+		cycles = rdtsc () - start;
+		if (cycles > awake_max_cycles)
+			awake_max_cycles = cycles;
+		intr_set_level (old_level);
+	} while (woken == AWAKE_BATCH);
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -184,6 +367,11 @@ real_time_sleep (int64_t num, int32_t denom) {
 		   timer_sleep() because it will yield the CPU to other
 		   processes. */
 		timer_sleep (ticks);
+	} else if (timer_tickless) {
+		/* A one-shot interrupt can end a sub-tick sleep, so block
+		   instead of spinning.  NUM is less than a tick's worth of
+		   DENOM, so this cannot overflow. */
+		clock_sleep (num * PIT_HZ / denom);
 	} else {
 		/* Otherwise, use a busy-wait loop for more accurate
 		   sub-tick timing.  We scale the numerator and denominator
@@ -192,3 +380,97 @@ real_time_sleep (int64_t num, int32_t denom) {
 		busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
 	}
 }
+
+/* Blocks the current thread for CLOCKS timer clocks, arming the
+   one-shot timer earlier if needed.  Only used with -tickless. */
+static void
+clock_sleep (int64_t clocks) {
+	enum intr_level old_level;
+	int64_t deadline, late;
+
+	if (clocks <= 0)
+		return;
+
+	old_level = intr_disable ();
+	deadline = clock_now () + clocks;
+	if (deadline < pit_expiry)
+		pit_arm (deadline);
+	thread_sleep (deadline);
+
+	late = clock_now () - deadline;
+	hires_sleeps++;
+	hires_late += late;
+	if (late > hires_late_max)
+		hires_late_max = late;
+	intr_set_level (old_level);
+}
+
+/* Returns the number of timer clocks since the OS booted.  In
+   periodic mode this only advances once per tick.  Interrupts
+   must be off. */
+static int64_t
+clock_now (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	return timer_tickless ? pit_clock + pit_elapsed () : ticks * TICK_CLOCKS;
+}
+
+/* Returns when the next timer interrupt is needed after NOW,
+   for a CPU that is running a thread: at the next tick boundary,
+   to drive time slicing, or earlier if a sleeper is due. */
+static int64_t
+next_event (int64_t now) {
+	int64_t next_tick = (now / TICK_CLOCKS + 1) * TICK_CLOCKS;
+	int64_t next_wakeup = get_next_tick_to_awake ();
+
+	return next_wakeup < next_tick ? next_wakeup : next_tick;
+}
+
+/* Starts counter 0 counting down COUNT clocks in mode 0, which
+   raises IRQ 0 once when the count reaches zero. */
+static void
+pit_load (uint16_t count) {
+	outb (0x43, 0x30);    /* CW: counter 0, LSB then MSB, mode 0, binary. */
+	outb (0x40, count & 0xff);
+	outb (0x40, count >> 8);
+	pit_armed = count;
+}
+
+/* Returns the number of timer clocks since counter 0 was last
+   loaded.  After reaching zero, a mode 0 counter keeps counting
+   down from 0xffff with its output high, so the overshoot can
+   still be recovered for up to 55 ms. */
+static int64_t
+pit_elapsed (void) {
+	uint8_t status, lo, hi;
+	uint16_t count;
+
+	outb (0x43, 0xc2);    /* Read-back: latch status and count of counter 0. */
+	status = inb (0x40);
+	lo = inb (0x40);
+	hi = inb (0x40);
+	count = lo | (hi << 8);
+
+	if (status & 0x80)    /* Output high: count reached zero. */
+		return pit_armed + (uint16_t) -count;
+	return pit_armed - count;
+}
+
+/* Reprograms the one-shot timer to interrupt at DEADLINE, in
+   timer clocks, or as close to it as the 16-bit counter allows.
+   Interrupts must be off. */
+static void
+pit_arm (int64_t deadline) {
+	int64_t clocks;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	pit_clock += pit_elapsed ();
+	clocks = deadline - pit_clock;
+	if (clocks < MIN_CLOCKS)
+		clocks = MIN_CLOCKS;
+	else if (clocks > 0xffff)
+		clocks = 0xffff;
+	pit_load (clocks);
+	pit_expiry = pit_clock + clocks;
+}
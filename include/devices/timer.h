@@ -2,13 +2,19 @@
 #define DEVICES_TIMER_H
 
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* -tickless: Use one-shot timer interrupts. */
+extern bool timer_tickless;
+
 void timer_init (void);
 void timer_calibrate (void);
+uint64_t timer_tsc_hz (void);
+uint64_t timer_cycles_to_ns (uint64_t cycles);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
@@ -19,5 +25,9 @@ void timer_usleep (int64_t microseconds);
 void timer_nsleep (int64_t nanoseconds);
 
 void timer_print_stats (void);
+uint64_t timer_awake_max_cycles (void);
+
+void timer_idle_enter (void);
+int64_t timer_idle_exit (void);
 
 #endif /* devices/timer.h */
@@ -0,0 +1,74 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Priority queue.
+ *
+ * This is a pairing heap.  Like the list and hash table, it does
+ * not use dynamically allocated memory: each structure that can
+ * be a heap element must embed a struct heap_elem member, and
+ * heap_entry() converts a struct heap_elem back into the
+ * structure that contains it.
+ *
+ * The heap is ordered by a caller-supplied "less than" function
+ * and heap_min() returns the least element, so a max-heap is just
+ * a heap whose less function compares in reverse.  Elements that
+ * compare equal come out in the order they were inserted.
+ *
+ * Costs, for a heap of N elements:
+ *
+ * - heap_insert(), heap_min(): O(1).
+ *
+ * - heap_pop_min(), heap_remove(): O(log N) amortized.
+ *
+ * An element whose key changes while it is in a heap must be
+ * removed with heap_remove() before the change and inserted
+ * again afterward.  It then counts as newly inserted for the
+ * purpose of ordering equal elements. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem {
+	struct heap_elem *child;    /* Leftmost child. */
+	struct heap_elem *next;     /* Next sibling. */
+	struct heap_elem *prev;     /* Previous sibling, or parent. */
+	uint64_t seq;               /* Insertion order. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+   the structure that HEAP_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)           \
+	((STRUCT *) ((uint8_t *) (HEAP_ELEM)            \
+		- offsetof (STRUCT, MEMBER)))
+
+/* Compares the value of two heap elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+                             const struct heap_elem *b,
+                             void *aux);
+
+/* Heap. */
+struct heap {
+	struct heap_elem *root;     /* Least element, or null. */
+	size_t size;                /* Number of elements. */
+	uint64_t next_seq;          /* Next insertion sequence number. */
+	heap_less_func *less;       /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+
+void heap_insert (struct heap *, struct heap_elem *);
+struct heap_elem *heap_min (const struct heap *);
+struct heap_elem *heap_pop_min (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+
+size_t heap_size (const struct heap *);
+bool heap_empty (const struct heap *);
+
+#endif /* lib/kernel/heap.h */
@@ -0,0 +1,20 @@
+#ifndef __LIB_RUSAGE_H
+#define __LIB_RUSAGE_H
+
+#include <stdint.h>
+
+/* Resource usage of a process, as reported by getrusage().
+   Shared by the kernel and user programs. */
+struct rusage {
+	uint64_t utime_ns;          /* Time spent in user mode. */
+	uint64_t stime_ns;          /* Time spent in the kernel. */
+	uint64_t utime_cycles;      /* utime_ns in TSC cycles. */
+	uint64_t stime_cycles;      /* stime_ns in TSC cycles. */
+	uint64_t page_faults;       /* Page faults taken. */
+	uint64_t disk_reads;        /* Disk sectors read. */
+	uint64_t disk_writes;       /* Disk sectors written. */
+	uint64_t vol_switches;      /* Times it blocked, yielded or exited. */
+	uint64_t invol_switches;    /* Times it was preempted. */
+};
+
+#endif /* lib/rusage.h */
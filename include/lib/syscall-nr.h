@@ -36,6 +36,16 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Synchronization. */
+	SYS_FUTEX,                  /* Wait on or wake a user lock word. */
+	SYS_GETRUSAGE,              /* Report resource usage. */
+};
+
+/* Operations for SYS_FUTEX. */
+enum {
+	FUTEX_WAIT,                 /* Sleep if the word holds a value. */
+	FUTEX_WAKE,                 /* Wake up to N sleepers. */
 };
 
 #endif /* lib/syscall-nr.h */
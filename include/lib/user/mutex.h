@@ -0,0 +1,39 @@
+#ifndef __LIB_USER_MUTEX_H
+#define __LIB_USER_MUTEX_H
+
+#include <stdbool.h>
+
+/* User-level mutex and condition variable, built on futexes.
+
+   Both live in ordinary memory.  Locking an unheld mutex,
+   unlocking one that no one waits for, and signaling a condition
+   that no one waits on are done with atomic instructions alone
+   and never enter the kernel.  To synchronize processes, put them
+   in a mapping shared between them. */
+
+/* Mutex. */
+struct mutex {
+	int state;                  /* 0 = unheld, 1 = held, 2 = held, maybe waiters. */
+};
+
+#define MUTEX_INITIALIZER { 0 }
+
+void mutex_init (struct mutex *);
+void mutex_lock (struct mutex *);
+bool mutex_trylock (struct mutex *);
+void mutex_unlock (struct mutex *);
+
+/* Condition variable. */
+struct cond {
+	int seq;                    /* Bumped by every signal. */
+	int waiters;                /* Number of threads in cond_wait(). */
+};
+
+#define COND_INITIALIZER { 0, 0 }
+
+void cond_init (struct cond *);
+void cond_wait (struct cond *, struct mutex *);
+void cond_signal (struct cond *, struct mutex *);
+void cond_broadcast (struct cond *, struct mutex *);
+
+#endif /* lib/user/mutex.h */
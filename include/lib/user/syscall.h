@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <rusage.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -50,6 +51,13 @@ bool isdir (int fd);
 int inumber (int fd);
 int symlink (const char* target, const char* linkpath);
 
+/* Synchronization.  See <mutex.h> for locks built on these. */
+int futex_wait (int *addr, int expected);
+int futex_wake (int *addr, int n);
+
+/* Accounting. */
+int getrusage (struct rusage *);
+
 static inline void* get_phys_addr (void *user_addr) {
 	void* pa;
 	asm volatile ("movq %0, %%rax" ::"r"(user_addr));
@@ -0,0 +1,33 @@
+#ifndef THREADS_ALLOCPROF_H
+#define THREADS_ALLOCPROF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Allocation profiler.
+
+   While it runs, palloc and malloc report every allocation they
+   hand out, with the return address of the call that asked for
+   it, and every allocation they take back.  The profiler keeps
+   a table of the allocations still live, so that it can total
+   allocations and bytes by call site, both ever allocated and
+   still outstanding.  Outstanding allocations at power-off are
+   leaks, or memory that is never meant to be freed. */
+
+/* Allocator an allocation came from. */
+enum alloc_kind {
+	ALLOC_PALLOC,               /* palloc_get_page(), ... */
+	ALLOC_MALLOC                /* malloc(), calloc(), realloc(). */
+};
+
+extern bool alloc_profile;
+
+bool alloc_profile_start (void);
+void alloc_profile_record (enum alloc_kind, void *, size_t size,
+		uintptr_t site);
+void alloc_profile_forget (void *);
+void alloc_profile_outstanding (uint64_t *cnt, uint64_t *bytes);
+void alloc_dump_profile (void);
+
+#endif /* threads/allocprof.h */
@@ -0,0 +1,42 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include "threads/interrupt.h"
+
+struct thread;
+
+/* Per-CPU state.
+
+   Each CPU runs on the stack of its current thread, so
+   running_thread() and thread_current() already give the right
+   answer on every CPU: they round the stack pointer down to the
+   thread's page.  Everything else a CPU owns lives here, and a
+   thread finds its CPU through its `cpu' member, which
+   switch_to() sets whenever a CPU picks the thread up.
+
+   Only the bootstrap CPU is brought up for now, so cpu_cnt is
+   always 1. */
+#define CPU_MAX 16                  /* Most CPUs supported. */
+
+struct cpu {
+	int id;                         /* Index in cpus[]. */
+	struct thread *idle;            /* This CPU's idle thread. */
+	unsigned thread_ticks;          /* # of timer ticks since last yield. */
+	struct thread *dying;           /* Exited thread whose page to recycle. */
+
+	/* Statistics. */
+	long long idle_ticks;           /* # of timer ticks spent idle. */
+	long long kernel_ticks;         /* # of timer ticks in kernel threads. */
+	long long user_ticks;           /* # of timer ticks in user programs. */
+
+	/* Owned by spinlock.c. */
+	int lock_depth;                 /* # of spinlocks held. */
+	enum intr_level lock_intr;      /* Interrupt level before the first. */
+};
+
+extern struct cpu cpus[CPU_MAX];
+extern int cpu_cnt;
+
+struct cpu *this_cpu (void);
+
+#endif /* threads/cpu.h */
@@ -14,6 +14,7 @@ enum intr_level intr_get_level (void);
 enum intr_level intr_set_level (enum intr_level);
 enum intr_level intr_enable (void);
 enum intr_level intr_disable (void);
+enum intr_level intr_disable_at (uintptr_t site);
 
 /* Interrupt stack frame. */
 struct gp_registers {
@@ -75,4 +76,13 @@ void intr_yield_on_return (void);
 void intr_dump_frame (const struct intr_frame *);
 const char *intr_name (uint8_t vec);
 
+uint64_t intr_max_cycles (void);
+void intr_clear_max_cycles (void);
+void intr_print_stats (void);
+
+extern bool intr_profile;
+uint64_t intr_off_max_cycles (void);
+void intr_profile_reset (void);
+void intr_dump_profile (void);
+
 #endif /* threads/interrupt.h */
@@ -1,6 +1,7 @@
 #ifndef THREADS_PALLOC_H
 #define THREADS_PALLOC_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 
@@ -20,4 +21,8 @@ void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
 
+bool palloc_zero_idle (void);
+void palloc_print_stats (void);
+void palloc_zero_stats (uint64_t *hits, uint64_t *misses);
+
 #endif /* threads/palloc.h */
@@ -0,0 +1,58 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <list.h>
+#include <stddef.h>
+#include "threads/synch.h"
+
+/* Object caches.
+
+   A cache hands out objects of one size, carved out of one-page
+   slabs, so an object takes only its own size rounded up to its
+   alignment, instead of the next power of two as with malloc().
+
+   If the cache has a constructor, each object is constructed
+   once, when its slab is created, and kmem_cache_free() must be
+   given it back in its constructed state; kmem_cache_alloc() then
+   hands it out again without constructing it anew.
+
+   Each cache keeps its slabs on three lists, by whether they are
+   partly used, fully used, or unused.  Allocation prefers partly
+   used slabs, so that unused ones can be given back to the page
+   allocator.  Successive slabs start their objects at different
+   offsets, spread over the space a slab cannot use anyway, so
+   that the objects at the same index in different slabs do not
+   all compete for the same cache lines. */
+
+typedef void kmem_ctor_func (void *obj);
+
+/* An object cache. */
+struct kmem_cache {
+	const char *name;           /* Name, for statistics. */
+	size_t size;                /* Object size requested. */
+	size_t slot_size;           /* Bytes per object in a slab. */
+	size_t link_ofs;            /* Offset of free-list link in a slot. */
+	size_t align;               /* Object alignment. */
+	size_t objs_per_slab;       /* Objects in each slab. */
+	size_t colour_max;          /* Largest colour offset. */
+	size_t colour_next;         /* Colour offset of next slab. */
+	kmem_ctor_func *ctor;       /* Constructor, or null. */
+
+	struct lock lock;           /* Protects the rest. */
+	struct list partial;        /* Slabs with used and free objects. */
+	struct list full;           /* Slabs with no free objects. */
+	struct list empty;          /* Slabs with no used objects. */
+	size_t slab_cnt;            /* Slabs on all three lists. */
+	size_t empty_cnt;           /* Slabs on `empty'. */
+	size_t obj_cnt;             /* Objects in use. */
+	struct list_elem elem;      /* Element in list of all caches. */
+};
+
+void slab_init (void);
+struct kmem_cache *kmem_cache_create (const char *name, size_t size,
+		size_t align, kmem_ctor_func *ctor);
+void *kmem_cache_alloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+void slab_print_stats (void);
+
+#endif /* threads/slab.h */
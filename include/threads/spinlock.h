@@ -0,0 +1,26 @@
+#ifndef THREADS_SPINLOCK_H
+#define THREADS_SPINLOCK_H
+
+#include <stdbool.h>
+
+/* Spin lock.
+
+   Protects data shared between CPUs for short stretches of code
+   that must not sleep, such as the scheduler's run queues.  A
+   CPU holding a spin lock runs with interrupts off, so an
+   interrupt handler on the same CPU cannot try to take a lock
+   its own CPU already holds; interrupts come back on when the
+   CPU releases its last spin lock, if they were on before its
+   first.  Spin locks do not nest recursively. */
+struct spinlock {
+	volatile int locked;        /* Nonzero while held. */
+	struct cpu *cpu;            /* CPU holding the lock, for debugging. */
+	const char *name;           /* Name, for debugging. */
+};
+
+void spinlock_init (struct spinlock *, const char *name);
+void spinlock_acquire (struct spinlock *);
+void spinlock_release (struct spinlock *);
+bool spinlock_held (const struct spinlock *);
+
+#endif /* threads/spinlock.h */
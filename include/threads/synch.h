@@ -1,23 +1,39 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
 
+struct thread;
+
+/* Priority wait queue.
+
+   Threads waiting for an event, kept in a heap so that the one
+   with the highest priority comes out first and threads of equal
+   priority come out in the order they arrived.  A waiting thread
+   whose priority changes, through donation or otherwise, is moved
+   to match (see thread_requeue()).  Interrupts must be off while
+   a wait queue is used. */
+struct waitq {
+	struct heap waiters;        /* Waiting threads. */
+};
+
+void waitq_init (struct waitq *);
+bool waitq_empty (const struct waitq *);
+void waitq_push (struct waitq *, struct thread *);
+struct thread *waitq_pop (struct waitq *);
+void waitq_remove (struct waitq *, struct thread *);
+
 /* A counting semaphore. */
 struct semaphore {
 	unsigned value;             /* Current value. */
-	struct list waiters;        /* List of waiting threads. */
+	struct waitq waiters;       /* Waiting threads. */
+	bool handoff;               /* Switch straight to woken waiters? */
 };
 
-
-//?<-----------------edit---------------------->
-bool cmp_sem_priority (const struct list_elem *a, 
-  const struct list_elem *b, 
-  void *aux);
-//?<-----------------edit---------------------->
-
 void sema_init (struct semaphore *, unsigned value);
+void sema_set_handoff (struct semaphore *, bool);
 void sema_down (struct semaphore *);
 bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
@@ -27,17 +43,80 @@ void sema_self_test (void);
 struct lock {
 	struct thread *holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+	struct heap donors;         /* Waiting threads, highest priority first. */
+	struct list_elem elem;      /* Element in holder's held_locks. */
+	bool contended;             /* In holder's held_locks? */
 };
 
 void lock_init (struct lock *);
+void lock_set_handoff (struct lock *, bool);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 
+/* Priority-ceiling lock.
+
+   A lock under the immediate priority ceiling protocol.  Each one
+   has a fixed ceiling, which must be at least the priority of any
+   thread that will use it, and its holder runs at no less than
+   the ceiling for as long as it holds it.  No thread that might
+   want the lock can then preempt the holder, so on one CPU the
+   lock is only ever contended if its holder sleeps, and there is
+   nothing to donate: acquiring and releasing it costs a priority
+   change each way, with no donor heaps and no chain walking.
+
+   The price is that the holder also shuts out every other thread
+   at or below the ceiling, whether it wants the lock or not, so
+   it suits short critical sections that never sleep and whose
+   users' priorities are known.  In this kernel, that describes
+   tid_lock in thread.c, the pool locks in palloc.c and the
+   descriptor locks in malloc.c.  It does not describe the disk
+   channel locks, the intq locks or the FAT write lock, all of
+   which are held across waits for devices.
+
+   Under the MLFQS, which ignores donation, the ceiling is
+   ignored too. */
+struct ceiling_lock {
+	struct thread *holder;      /* Thread holding lock. */
+	struct semaphore semaphore; /* Binary semaphore controlling access. */
+	int ceiling;                /* Priority while held. */
+	struct list_elem elem;      /* Element in holder's ceiling_locks. */
+};
+
+void ceiling_lock_init (struct ceiling_lock *, int ceiling);
+void ceiling_lock_acquire (struct ceiling_lock *);
+void ceiling_lock_release (struct ceiling_lock *);
+bool ceiling_lock_held_by_current_thread (const struct ceiling_lock *);
+
+/* Reader-writer lock.
+
+   Any number of readers, or a single writer, can hold it at a
+   time.  A writer holds `gate' from the moment it starts waiting
+   until it releases the lock, and readers pass through `gate' on
+   the way in, so no new reader gets in once a writer is waiting.
+
+   Priority donation works as for locks: threads waiting for
+   `gate' donate to its holder, and the writer waiting for readers
+   to leave donates to each of them. */
+struct rwlock {
+	struct lock gate;           /* Held by the writer. */
+	unsigned readers;           /* Number of threads holding it shared. */
+	struct list holds;          /* Their struct rwlock_hold records. */
+	struct thread *drainer;     /* Writer waiting for readers to leave. */
+	struct semaphore drained;   /* Upped when the last reader leaves. */
+};
+
+void rwlock_init (struct rwlock *);
+void rwlock_read_acquire (struct rwlock *);
+void rwlock_read_release (struct rwlock *);
+void rwlock_write_acquire (struct rwlock *);
+void rwlock_write_release (struct rwlock *);
+bool rwlock_write_held_by_current_thread (const struct rwlock *);
+
 /* Condition variable. */
 struct condition {
-	struct list waiters;        /* List of waiting threads. */
+	struct waitq waiters;       /* Waiting threads. */
 };
 
 void cond_init (struct condition *);
@@ -45,8 +124,6 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
-bool cmp_priority(const struct list_elem *a, const struct list_elem *b, void *aux);
-
 /* Optimization barrier.
  *
  * The compiler will not reorder operations across an
@@ -2,9 +2,11 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <heap.h>
 #include <list.h>
 #include <stdint.h>
 #include "threads/interrupt.h"
+#include "threads/fixed-point.h"
 #ifdef VM
 #include "vm/vm.h"
 #endif
@@ -28,6 +30,27 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
+/* Thread niceness, for the multi-level feedback queue scheduler. */
+#define NICE_MIN -20                    /* Nicest to other threads. */
+#define NICE_DEFAULT 0                  /* Default niceness. */
+#define NICE_MAX 20                     /* Least nice to other threads. */
+
+struct cpu;
+struct rwlock;
+
+/* A shared hold on a reader-writer lock (synch.c).  It lets a
+   writer that is waiting for readers to leave donate its priority
+   to each of them. */
+struct rwlock_hold {
+	struct rwlock *rwlock;              /* Lock held, or null if unused. */
+	struct thread *thread;              /* Thread holding it. */
+	struct list_elem elem;              /* Element in rwlock's holds. */
+};
+
+/* Maximum number of reader-writer locks a thread can hold shared
+   at once. */
+#define RWLOCK_READ_MAX 4
+
 /* A kernel thread or user process.
  *
  * Each thread structure is stored in its own 4 kB page.  The
@@ -79,29 +102,74 @@ typedef int tid_t;
  * the `magic' member of the running thread's `struct thread' is
  * set to THREAD_MAGIC.  Stack overflow will normally change this
  * value, triggering the assertion. */
-/* The `elem' member has a dual purpose.  It can be an element in
- * the run queue (thread.c), or it can be an element in a
- * semaphore wait list (synch.c).  It can be used these two ways
- * only because they are mutually exclusive: only a thread in the
- * ready state is on the run queue, whereas only a thread in the
- * blocked state is on a semaphore wait list. */
+/* The `elem' member is an element in the run queue (thread.c),
+ * or in the cache of free thread pages once the thread is dead.
+ * A thread waiting on a semaphore or condition variable is in
+ * that object's wait queue (synch.c) through `waitq_elem'
+ * instead. */
 struct thread {
 	/* Owned by thread.c. */
 	tid_t tid;                          /* Thread identifier. */
 	enum thread_status status;          /* Thread state. */
 	char name[16];                      /* Name (for debugging purposes). */
 	int priority;                       /* Priority. */
-  int64_t wakeup_tick;                /* wakeup_tick */
+  int64_t wakeup_tick;                /* Timer clock to wake up at. */
+	struct heap_elem sleep_elem;        /* sleep_heap element. */
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem;
+	struct waitq *waitq;                /* Wait queue we are in, if any. */
+	struct heap_elem waitq_elem;        /* Element in waitq. */
 	
 	//?<------------>
 	int init_priority;
 	struct lock* wait_on_lock;
-	struct list donations;
-	struct list_elem donation_elem;
+	struct list held_locks;             /* Locks held, for donation. */
+	struct list ceiling_locks;          /* Ceiling locks held. */
+	int wait_ceiling;                   /* Ceiling of lock awaited, or PRI_MIN. */
+	struct heap_elem donor_elem;        /* Element in wait_on_lock's donors. */
+	struct rwlock *wait_on_rwlock;      /* Rwlock whose readers we wait on. */
+	struct rwlock_hold read_holds[RWLOCK_READ_MAX]; /* Shared holds. */
 	//?<------------>
 
+	/* Multi-level feedback queue scheduler (thread.c). */
+	bool fixed_priority;                /* Keeps its priority under the MLFQS. */
+	int nice;                           /* Niceness. */
+	fixed_t recent_cpu;                 /* Recent CPU time received. */
+	bool cpu_dirty;                     /* On dirty_list? */
+	struct list_elem dirty_elem;        /* dirty_list element. */
+	struct list_elem all_elem;          /* all_list element. */
+
+	/* Scheduler accounting (thread.c), in TSC cycles. */
+	uint64_t run_cycles;                /* Time spent running. */
+	uint64_t wait_cycles;               /* Time spent in the run queue. */
+	uint64_t run_stamp;                 /* When it last started running. */
+	uint64_t ready_stamp;               /* When it last became ready. */
+	unsigned vol_switches;              /* # of times it blocked, yielded or exited. */
+	unsigned invol_switches;            /* # of times it was preempted. */
+	unsigned donations_received;        /* # of priority donations received. */
+
+	/* Resource usage, reported by getrusage(). */
+	uint64_t user_cycles;               /* Time spent in user mode, in TSC cycles. */
+	uint64_t user_stamp;                /* When it last returned to user mode. */
+	unsigned page_faults;               /* # of page faults taken. */
+	unsigned disk_reads;                /* # of disk sectors read. */
+	unsigned disk_writes;               /* # of disk sectors written. */
+
+	/* Earliest-deadline-first class (thread.c), in timer ticks. */
+	bool edf;                           /* In the EDF class? */
+	bool edf_throttled;                 /* Out of budget until edf_release? */
+	int edf_bandwidth;                  /* Reserved, in 1/1000 of the CPU. */
+	int64_t edf_runtime;                /* CPU time per period. */
+	int64_t edf_period;                 /* Period. */
+	int64_t edf_deadline;               /* Deadline, relative to release. */
+	int64_t edf_budget;                 /* CPU time left for current job. */
+	int64_t edf_abs_deadline;           /* Current job's deadline. */
+	int64_t edf_release;                /* Start of next period. */
+	unsigned edf_misses;                /* # of jobs that ended late. */
+	unsigned edf_overruns;              /* # of times throttled. */
+	struct heap_elem edf_elem;          /* EDF run queue element. */
+	struct list_elem edf_list_elem;     /* edf_list element. */
+
 
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
@@ -113,7 +181,9 @@ struct thread {
 #endif
 
 	/* Owned by thread.c. */
+	struct cpu *cpu;                    /* CPU it runs or last ran on. */
 	struct intr_frame tf;               /* Information for switching */
+	uint64_t switch_rsp;                /* Saved stack pointer, or 0 if never run. */
 	unsigned int magic;                     /* Detects stack overflow. */
 };
 
@@ -122,17 +192,23 @@ struct thread {
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* Maximum number of lock holders a priority donation is passed
+   along.  Controlled by kernel command-line option
+   "-donate-depth=N". */
+extern int donate_depth;
+
 void thread_init (void);
 void thread_start (void);
 
 void thread_tick (void);
 void thread_print_stats (void);
+void thread_dump_sched (void);
 
 //alarm clock
 void thread_sleep(int64_t);
 void update_next_tick_to_awake(int64_t);
 int64_t get_next_tick_to_awake(void);
-void thread_awake(int64_t);
+int thread_awake(int64_t, int max);
 
 //priority scheduling
 void test_max_priority(void);
@@ -145,6 +221,7 @@ tid_t thread_create (const char *name, int priority, thread_func *, void *);
 
 void thread_block (void);
 void thread_unblock (struct thread *);
+void thread_handoff (struct thread *);
 
 struct thread *thread_current (void);
 tid_t thread_tid (void);
@@ -152,9 +229,20 @@ const char *thread_name (void);
 
 void thread_exit (void) NO_RETURN;
 void thread_yield (void);
+void thread_preempt (void);
 
 int thread_get_priority (void);
 void thread_set_priority (int);
+void thread_set_fixed_priority (int);
+
+bool thread_set_edf (int64_t runtime, int64_t period, int64_t deadline);
+void thread_clear_edf (void);
+void thread_edf_yield (void);
+
+struct rusage;
+void thread_enter_kernel (void);
+void thread_leave_kernel (void);
+void thread_get_rusage (struct rusage *);
 
 int thread_get_nice (void);
 void thread_set_nice (int);
@@ -163,8 +251,7 @@ int thread_get_load_avg (void);
 
 void do_iret (struct intr_frame *tf);
 
-void donate_priority(void);
-void remove_with_lock(struct lock *lock);
+void donate_priority(struct thread *);
 void refresh_priority(void);
 
 #endif /* threads/thread.h */
@@ -0,0 +1,60 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Deferred work.
+
+   An interrupt handler that has more to do than acknowledge its
+   device queues a struct work and returns.  One of the queue's
+   worker threads later calls the work's function, with interrupts
+   on, at the priority the queue was created with.
+
+   A work item is queued at most once at a time: queuing one that
+   is still pending does nothing, so a burst of interrupts of the
+   same kind is handled by a single call that catches up on all of
+   them.  A work item may be queued again once its function has
+   started. */
+
+struct work;
+typedef void work_func (struct work *);
+
+/* A unit of deferred work. */
+struct work {
+	work_func *func;            /* Function to call. */
+	void *aux;                  /* For FUNC's use. */
+	bool pending;               /* Queued and not yet started? */
+	struct list_elem elem;      /* Element in a workqueue's items. */
+};
+
+/* A queue of work and the threads that run it. */
+struct workqueue {
+	const char *name;           /* Name, for the worker threads. */
+	struct list items;          /* Pending work, oldest first. */
+	struct semaphore ready;     /* Counts pending work. */
+	int worker_cnt;             /* Number of worker threads. */
+	long long run_cnt;          /* # of work functions run. */
+	long long merge_cnt;        /* # of queue requests merged. */
+};
+
+/* Priority of the system workqueue's workers. */
+#define WQ_PRI_DEFAULT PRI_MAX
+
+extern struct workqueue system_wq;
+
+void workqueue_init (void);
+void workqueue_create (struct workqueue *, const char *name,
+		int priority, int worker_cnt);
+void workqueue_print_stats (void);
+
+void work_init (struct work *, work_func *, void *aux);
+bool work_queue (struct workqueue *, struct work *);
+
+/* If true, work_queue() runs work at once, in the caller's
+   context, instead of deferring it.  For comparison only. */
+extern bool workqueue_bypass;
+
+#endif /* threads/workqueue.h */
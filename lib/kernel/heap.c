@@ -0,0 +1,183 @@
+/* Pairing heap.
+
+   See heap.h for basic information.
+
+   Each element keeps a pointer to its leftmost child and is
+   linked to its siblings through `next' and `prev'.  The
+   leftmost child's `prev' points to its parent instead, which is
+   what lets heap_remove() unlink an arbitrary element in
+   constant time.  The root has null `next' and `prev'.
+
+   Merging the children of a removed element uses the standard
+   two-pass scheme, done iteratively so that a long sibling list
+   cannot overflow the kernel stack. */
+
+#include "heap.h"
+#include "../debug.h"
+
+static bool before (const struct heap *,
+		const struct heap_elem *, const struct heap_elem *);
+static struct heap_elem *link (const struct heap *,
+		struct heap_elem *, struct heap_elem *);
+static struct heap_elem *merge_pairs (const struct heap *,
+		struct heap_elem *first);
+
+/* Initializes H as an empty heap ordered by LESS, given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux) {
+	ASSERT (h != NULL);
+	ASSERT (less != NULL);
+
+	h->root = NULL;
+	h->size = 0;
+	h->next_seq = 0;
+	h->less = less;
+	h->aux = aux;
+}
+
+/* Inserts E into H. */
+void
+heap_insert (struct heap *h, struct heap_elem *e) {
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+
+	e->child = e->next = e->prev = NULL;
+	e->seq = h->next_seq++;
+	h->root = h->root != NULL ? link (h, h->root, e) : e;
+	h->size++;
+}
+
+/* Returns the least element in H, or a null pointer if H is
+   empty. */
+struct heap_elem *
+heap_min (const struct heap *h) {
+	ASSERT (h != NULL);
+
+	return h->root;
+}
+
+/* Removes the least element from H and returns it.  H must not
+   be empty. */
+struct heap_elem *
+heap_pop_min (struct heap *h) {
+	struct heap_elem *min;
+
+	ASSERT (h != NULL);
+	ASSERT (h->root != NULL);
+
+	min = h->root;
+	h->root = merge_pairs (h, min->child);
+	h->size--;
+	min->child = NULL;
+	return min;
+}
+
+/* Removes E, which must be in H, from H. */
+void
+heap_remove (struct heap *h, struct heap_elem *e) {
+	struct heap_elem *sub;
+
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+
+	if (e == h->root) {
+		heap_pop_min (h);
+		return;
+	}
+
+	/* Unlink E, together with its subtree, from its parent. */
+	ASSERT (e->prev != NULL);
+	if (e->prev->child == e)
+		e->prev->child = e->next;
+	else
+		e->prev->next = e->next;
+	if (e->next != NULL)
+		e->next->prev = e->prev;
+
+	/* Merge E's children back into the heap. */
+	sub = merge_pairs (h, e->child);
+	if (sub != NULL)
+		h->root = link (h, h->root, sub);
+	h->size--;
+	e->child = e->next = e->prev = NULL;
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size (const struct heap *h) {
+	return h->size;
+}
+
+/* Returns true if H is empty, false otherwise. */
+bool
+heap_empty (const struct heap *h) {
+	return h->root == NULL;
+}
+
+/* Returns true if A must come out of H before B: A is less than
+   B, or they are equal and A was inserted first. */
+static bool
+before (const struct heap *h,
+		const struct heap_elem *a, const struct heap_elem *b) {
+	if (h->less (a, b, h->aux))
+		return true;
+	if (h->less (b, a, h->aux))
+		return false;
+	return a->seq < b->seq;
+}
+
+/* Links the roots A and B, making the one that comes out later
+   the leftmost child of the other, and returns the new root. */
+static struct heap_elem *
+link (const struct heap *h, struct heap_elem *a, struct heap_elem *b) {
+	if (before (h, b, a)) {
+		struct heap_elem *t = a;
+		a = b;
+		b = t;
+	}
+
+	b->prev = a;
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+	a->next = a->prev = NULL;
+	return a;
+}
+
+/* Merges the sibling list starting at FIRST into a single tree
+   and returns its root, or a null pointer if FIRST is null.
+
+   The first pass links siblings in pairs from left to right,
+   chaining the results through `next' in reverse order.  The
+   second pass then links the pairs from right to left. */
+static struct heap_elem *
+merge_pairs (const struct heap *h, struct heap_elem *first) {
+	struct heap_elem *pairs = NULL;
+	struct heap_elem *root = NULL;
+
+	while (first != NULL) {
+		struct heap_elem *a = first;
+		struct heap_elem *b = a->next;
+
+		if (b != NULL) {
+			first = b->next;
+			a = link (h, a, b);
+		} else {
+			first = NULL;
+			a->prev = NULL;
+		}
+		a->next = pairs;
+		pairs = a;
+	}
+
+	while (pairs != NULL) {
+		struct heap_elem *next = pairs->next;
+
+		pairs->next = pairs->prev = NULL;
+		root = root != NULL ? link (h, root, pairs) : pairs;
+		pairs = next;
+	}
+	return root;
+}
@@ -0,0 +1,120 @@
+#include <mutex.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <syscall.h>
+
+/* The mutex follows "mutex2" in Ulrich Drepper's "Futexes Are
+   Tricky".  Only a thread that finds the mutex held sets its
+   state to 2, and only an unlock that finds 2 has to call
+   futex_wake(). */
+
+/* Atomically sets *P to NEW if it holds OLD, and returns the value
+   *P held before. */
+static inline int
+cmpxchg (int *p, int old, int new) {
+	int prev;
+	asm volatile ("lock cmpxchgl %2, %1"
+			: "=a" (prev), "+m" (*p)
+			: "r" (new), "0" (old)
+			: "memory");
+	return prev;
+}
+
+/* Atomically sets *P to NEW and returns the value it held
+   before. */
+static inline int
+xchg (int *p, int new) {
+	asm volatile ("xchgl %0, %1"
+			: "+r" (new), "+m" (*p)
+			:
+			: "memory");
+	return new;
+}
+
+/* Atomically adds N to *P. */
+static inline void
+atomic_add (int *p, int n) {
+	asm volatile ("lock addl %1, %0"
+			: "+m" (*p)
+			: "ir" (n)
+			: "memory");
+}
+
+/* Initializes M as unheld. */
+void
+mutex_init (struct mutex *m) {
+	m->state = 0;
+}
+
+/* Acquires M, sleeping in the kernel only while another thread
+   holds it. */
+void
+mutex_lock (struct mutex *m) {
+	int c = cmpxchg (&m->state, 0, 1);
+
+	if (c == 0)
+		return;
+	if (c != 2)
+		c = xchg (&m->state, 2);
+	while (c != 0) {
+		futex_wait (&m->state, 2);
+		c = xchg (&m->state, 2);
+	}
+}
+
+/* Acquires M if it is unheld and returns true, or returns false
+   without waiting. */
+bool
+mutex_trylock (struct mutex *m) {
+	return cmpxchg (&m->state, 0, 1) == 0;
+}
+
+/* Releases M, waking one waiter if there may be any. */
+void
+mutex_unlock (struct mutex *m) {
+	if (xchg (&m->state, 0) == 2)
+		futex_wake (&m->state, 1);
+}
+
+/* Initializes C. */
+void
+cond_init (struct cond *c) {
+	c->seq = 0;
+	c->waiters = 0;
+}
+
+/* Atomically releases M and waits for C to be signaled, then
+   reacquires M.  As with any Mesa-style condition variable, the
+   caller must check its condition again on return. */
+void
+cond_wait (struct cond *c, struct mutex *m) {
+	int seq;
+
+	atomic_add (&c->waiters, 1);
+	seq = c->seq;
+	mutex_unlock (m);
+	futex_wait (&c->seq, seq);
+
+	/* Someone else may have been woken with us, so take M as if
+	   contended, leaving the wake-up to our unlock. */
+	while (xchg (&m->state, 2) != 0)
+		futex_wait (&m->state, 2);
+	atomic_add (&c->waiters, -1);
+}
+
+/* Wakes one thread waiting on C, if any.  M must be held, which
+   is what lets this skip the kernel when no one is waiting. */
+void
+cond_signal (struct cond *c, struct mutex *m UNUSED) {
+	atomic_add (&c->seq, 1);
+	if (c->waiters > 0)
+		futex_wake (&c->seq, 1);
+}
+
+/* Wakes every thread waiting on C.  M must be held. */
+void
+cond_broadcast (struct cond *c, struct mutex *m UNUSED) {
+	atomic_add (&c->seq, 1);
+	if (c->waiters > 0)
+		futex_wake (&c->seq, INT_MAX);
+}
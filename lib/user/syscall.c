@@ -194,3 +194,18 @@ int
 umount (const char *path) {
 	return syscall1 (SYS_UMOUNT, path);
 }
+
+int
+futex_wait (int *addr, int expected) {
+	return syscall3 (SYS_FUTEX, addr, FUTEX_WAIT, expected);
+}
+
+int
+futex_wake (int *addr, int n) {
+	return syscall3 (SYS_FUTEX, addr, FUTEX_WAKE, n);
+}
+
+int
+getrusage (struct rusage *ru) {
+	return syscall1 (SYS_GETRUSAGE, ru);
+}
@@ -139,6 +139,40 @@ sub get_core_output {
     return @output[$start...$end];
 }
 
+# Checks the output of a run whose messages carry numbers that
+# vary from run to run, such as benchmark timings.  Each element
+# of EXPECTED stands for lines of core output, in order: a string
+# must equal one line, a qr// pattern must match all of one line,
+# and a reference to an array holding a qr// pattern matches one or
+# more consecutive lines.  No other output is allowed.
+sub check_patterns {
+    my (@expected) = @_;
+    my (@output) = read_text_file ("$test.output");
+    common_checks ("run", @output);
+    @output = get_core_output ("run", @output);
+
+    my ($i) = 0;
+    for my $want (@expected) {
+	my ($pattern, $repeat) = (ref ($want) eq 'ARRAY'
+				  ? ($want->[0], 1) : ($want, 0));
+	my ($desc) = ref ($pattern) ? "a line matching $pattern" : "\"$pattern\"";
+	fail "Expected $desc, but output ended\n" if $i > $#output;
+	fail "Expected $desc, got \"$output[$i]\"\n"
+	  if !line_matches ($output[$i], $pattern);
+	$i++;
+	$i++ while $repeat && $i <= $#output
+	  && line_matches ($output[$i], $pattern);
+    }
+    fail "Unexpected output \"$output[$i]\"\n" if $i <= $#output;
+}
+
+# Returns true if LINE equals PATTERN, if that is a string, or
+# matches all of it, if PATTERN is a qr// pattern.
+sub line_matches {
+    my ($line, $pattern) = @_;
+    return ref ($pattern) ? $line =~ /^$pattern$/ : $line eq $pattern;
+}
+
 sub compare_output {
     my ($run) = shift @_;
     my ($expected) = pop @_;
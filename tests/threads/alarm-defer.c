@@ -0,0 +1,84 @@
+/* Puts 500 threads to sleep until the same tick, twice: once
+   with the wakeups done inside the timer interrupt, as they were
+   before deferred work, and once with them done on the system
+   workqueue.  Checks that no thread wakes up early and reports
+   the longest external interrupt handler each time, which is the
+   longest stretch the wakeups kept interrupts off. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 500          /* Number of sleepers. */
+
+static thread_func sleeper;
+static uint64_t run_round (bool bypass);
+
+static struct semaphore done;
+static int64_t deadline;
+static int early;
+
+void
+test_alarm_defer (void) 
+{
+  uint64_t inline_cycles, deferred_cycles;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+  inline_cycles = run_round (true);
+  deferred_cycles = run_round (false);
+
+  msg ("%d simultaneous wakeups.", THREAD_CNT);
+  msg ("In the timer interrupt: longest handler %llu cycles.",
+       (unsigned long long) inline_cycles);
+  msg ("On the workqueue: longest handler %llu cycles.",
+       (unsigned long long) deferred_cycles);
+  if (early != 0)
+    fail ("%d threads woke up before their deadline", early);
+  pass ();
+}
+
+/* Sleeps THREAD_CNT threads until the same tick and waits for all
+   of them to wake.  Wakes them from the timer interrupt if BYPASS,
+   from the workqueue otherwise.  Returns the longest external
+   interrupt handler seen meanwhile. */
+static uint64_t
+run_round (bool bypass) 
+{
+  int i;
+
+  deadline = timer_ticks () + 50;
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "sleeper %d", i);
+      if (thread_create (name, PRI_DEFAULT, sleeper, NULL) == TID_ERROR)
+        fail ("thread_create failed for thread %d", i);
+    }
+
+  /* Every sleeper is asleep long before the deadline. */
+  timer_sleep (deadline - 10 - timer_ticks ());
+  workqueue_bypass = bypass;
+  intr_clear_max_cycles ();
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  workqueue_bypass = false;
+  return intr_max_cycles ();
+}
+
+/* Sleeper thread. */
+static void
+sleeper (void *aux UNUSED) 
+{
+  timer_sleep (deadline - timer_ticks ());
+  if (timer_ticks () < deadline)
+    early++;
+  sema_up (&done);
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(alarm-defer) begin',
+		'(alarm-defer) 500 simultaneous wakeups.',
+		qr/\(alarm-defer\) In the timer interrupt: longest handler \d+ cycles\./,
+		qr/\(alarm-defer\) On the workqueue: longest handler \d+ cycles\./,
+		'(alarm-defer) PASS',
+		'(alarm-defer) end');
+pass;
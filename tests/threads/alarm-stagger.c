@@ -0,0 +1,82 @@
+/* Creates 1,000 threads that each sleep until a different,
+   staggered deadline, and checks that none of them wakes up
+   early.  Also reports the most TSC cycles spent waking sleepers
+   with interrupts off in one pass, which should stay small
+   because a pass only touches threads that are due. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 1000         /* Number of sleepers. */
+#define SPREAD 200              /* Deadlines spread over this many ticks. */
+
+/* Information about a sleeper. */
+struct sleeper_info
+  {
+    int64_t deadline;           /* Tick to wake up at. */
+    int64_t woke;               /* Tick actually woken up at. */
+    struct semaphore *done;     /* Upped after waking. */
+  };
+
+static thread_func sleeper;
+
+void
+test_alarm_stagger (void) 
+{
+  struct sleeper_info *info;
+  struct semaphore done;
+  int64_t start;
+  int early = 0;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  info = malloc (sizeof *info * THREAD_CNT);
+  if (info == NULL)
+    PANIC ("couldn't allocate memory for test");
+
+  msg ("Creating %d threads with deadlines spread over %d ticks.",
+       THREAD_CNT, SPREAD);
+  sema_init (&done, 0);
+  start = timer_ticks () + 100;
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      char name[16];
+      info[i].deadline = start + (i * 7) % SPREAD;
+      info[i].done = &done;
+      snprintf (name, sizeof name, "sleeper %d", i);
+      if (thread_create (name, PRI_DEFAULT, sleeper, &info[i]) == TID_ERROR)
+        fail ("thread_create failed for thread %d", i);
+    }
+
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  for (i = 0; i < THREAD_CNT; i++)
+    if (info[i].woke < info[i].deadline)
+      early++;
+
+  msg ("Worst interrupts-off wakeup pass: %llu cycles.",
+       (unsigned long long) timer_awake_max_cycles ());
+  free (info);
+
+  if (early != 0)
+    fail ("%d threads woke up before their deadline", early);
+  pass ();
+}
+
+/* Sleeper thread. */
+static void
+sleeper (void *info_) 
+{
+  struct sleeper_info *info = info_;
+
+  timer_sleep (info->deadline - timer_ticks ());
+  info->woke = timer_ticks ();
+  sema_up (info->done);
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(alarm-stagger) begin',
+		'(alarm-stagger) Creating 1000 threads with deadlines spread over 200 ticks.',
+		qr/\(alarm-stagger\) Worst interrupts-off wakeup pass: \d+ cycles\./,
+		'(alarm-stagger) PASS',
+		'(alarm-stagger) end');
+pass;
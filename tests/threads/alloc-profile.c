@@ -0,0 +1,60 @@
+/* Turns on the allocation profiler, makes allocations from
+   malloc() and the page allocator, and checks that they are
+   counted as outstanding until they are freed.  Dumps the profile
+   while they are live, so the two sites here show up first. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/allocprof.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+#define BLOCK_CNT 32            /* Blocks from malloc(). */
+#define BLOCK_SIZE 100          /* Size of each block. */
+#define PAGE_CNT 4              /* Pages from palloc_get_multiple(). */
+
+void
+test_alloc_profile (void) 
+{
+  void *blocks[BLOCK_CNT];
+  uint64_t base_cnt, base_bytes, cnt, bytes;
+  void *pages;
+  int i;
+
+  if (!alloc_profile_start ())
+    fail ("could not start the allocation profiler");
+  alloc_profile_outstanding (&base_cnt, &base_bytes);
+
+  for (i = 0; i < BLOCK_CNT; i++) 
+    {
+      blocks[i] = malloc (BLOCK_SIZE);
+      if (blocks[i] == NULL)
+        fail ("malloc failed");
+    }
+  pages = palloc_get_multiple (0, PAGE_CNT);
+  if (pages == NULL)
+    fail ("palloc_get_multiple failed");
+
+  /* The pages malloc() took for its arenas count too. */
+  alloc_profile_outstanding (&cnt, &bytes);
+  if (cnt < base_cnt + BLOCK_CNT + 1
+      || bytes < base_bytes + BLOCK_CNT * BLOCK_SIZE + PAGE_CNT * PGSIZE)
+    fail ("%llu allocations of %llu bytes outstanding, expected more",
+          (unsigned long long) cnt, (unsigned long long) bytes);
+  msg ("Saw the outstanding allocations.");
+  alloc_dump_profile ();
+
+  for (i = 0; i < BLOCK_CNT; i++)
+    free (blocks[i]);
+  palloc_free_multiple (pages, PAGE_CNT);
+
+  alloc_profile_outstanding (&cnt, &bytes);
+  if (cnt != base_cnt || bytes != base_bytes)
+    fail ("%llu allocations of %llu bytes outstanding after freeing, "
+          "expected %llu of %llu",
+          (unsigned long long) cnt, (unsigned long long) bytes,
+          (unsigned long long) base_cnt, (unsigned long long) base_bytes);
+  msg ("Freed allocations are no longer outstanding.");
+  pass ();
+}
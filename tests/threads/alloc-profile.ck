@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(alloc-profile) begin',
+		'(alloc-profile) Saw the outstanding allocations.',
+		qr/Allocations at \d+ sites, \d+ outstanding \(\d+ bytes\)(, \d+ more allocations dropped)?:/,
+		qr/ +site +kind +allocs +bytes +live +live bytes +peak bytes/,
+		[qr/  0x[0-9a-f]{16} (palloc|malloc) +\d+ +\d+ +\d+ +\d+ +\d+/],
+		qr/Sites:( 0x[0-9a-f]+)+\./,
+		'(alloc-profile) Freed allocations are no longer outstanding.',
+		'(alloc-profile) PASS',
+		'(alloc-profile) end');
+pass;
@@ -0,0 +1,151 @@
+/* Has 4 threads of equal priority run critical sections under
+   one lock, long enough that the timer often preempts a holder,
+   first with a donating lock and then with a priority-ceiling
+   lock.  Reports the cycles per critical section for each, and
+   checks that no update under the lock is lost and that a
+   ceiling lock's holder runs at the ceiling and drops back
+   after.  Then has the holders of the ceiling lock sleep inside
+   their critical sections, so that the others queue up on it. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+
+#define THREAD_CNT 4            /* Threads contending. */
+#define SECTION_CNT 20000       /* Critical sections per thread. */
+#define SECTION_LEN 200         /* Busy-loop iterations per section. */
+#define SLEEP_CNT 20            /* Sleeping critical sections per thread. */
+
+static struct lock lock;
+static struct ceiling_lock ceiling_lock;
+static struct semaphore done;
+static int counter;
+
+static thread_func donating_worker, ceiling_worker, sleeping_worker;
+static uint64_t run (thread_func *, int section_cnt);
+
+void
+test_ceiling_bench (void) 
+{
+  uint64_t donating, ceiling;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  lock_init (&lock);
+  ceiling_lock_init (&ceiling_lock, PRI_DEFAULT + 1);
+  sema_init (&done, 0);
+
+  donating = run (donating_worker, SECTION_CNT);
+  ceiling = run (ceiling_worker, SECTION_CNT);
+  run (sleeping_worker, SLEEP_CNT);
+
+  msg ("Donating lock: %llu cycles per critical section.",
+       (unsigned long long) (donating / (THREAD_CNT * SECTION_CNT)));
+  msg ("Ceiling lock: %llu cycles per critical section.",
+       (unsigned long long) (ceiling / (THREAD_CNT * SECTION_CNT)));
+  pass ();
+}
+
+/* Runs THREAD_CNT copies of WORKER, which each run SECTION_CNT
+   critical sections, and returns the cycles they took to
+   finish. */
+static uint64_t
+run (thread_func *worker, int section_cnt) 
+{
+  uint64_t start, cycles;
+  int i;
+
+  /* Drop below the workers, so that we only collect them once
+     they have all finished. */
+  counter = 0;
+  thread_set_priority (PRI_MIN);
+  start = rdtsc ();
+  for (i = 0; i < THREAD_CNT; i++)
+    thread_create ("worker", PRI_DEFAULT, worker, NULL);
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  cycles = rdtsc () - start;
+  thread_set_priority (PRI_DEFAULT);
+
+  if (counter != THREAD_CNT * section_cnt)
+    fail ("counter is %d, expected %d", counter, THREAD_CNT * section_cnt);
+  return cycles;
+}
+
+/* Spins for a while between reading and writing the counter, so
+   that an update is lost unless the lock excludes the others. */
+static void
+section (void) 
+{
+  int c = counter;
+  volatile int i;
+
+  for (i = 0; i < SECTION_LEN; i++)
+    continue;
+  counter = c + 1;
+}
+
+static void
+donating_worker (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < SECTION_CNT; i++) 
+    {
+      lock_acquire (&lock);
+      section ();
+      lock_release (&lock);
+    }
+  sema_up (&done);
+}
+
+static void
+ceiling_worker (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < SECTION_CNT; i++) 
+    {
+      ceiling_lock_acquire (&ceiling_lock);
+      if (thread_get_priority () != PRI_DEFAULT + 1)
+        fail ("holder at priority %d, expected %d",
+              thread_get_priority (), PRI_DEFAULT + 1);
+      section ();
+      ceiling_lock_release (&ceiling_lock);
+      if (thread_get_priority () != PRI_DEFAULT)
+        fail ("priority %d after release, expected %d",
+              thread_get_priority (), PRI_DEFAULT);
+    }
+  sema_up (&done);
+}
+
+/* Sleeps while holding the ceiling lock, so that the other
+   workers block on it while it is held. */
+static void
+sleeping_worker (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < SLEEP_CNT; i++) 
+    {
+      int c;
+
+      ceiling_lock_acquire (&ceiling_lock);
+      if (thread_get_priority () != PRI_DEFAULT + 1)
+        fail ("holder at priority %d, expected %d",
+              thread_get_priority (), PRI_DEFAULT + 1);
+      c = counter;
+      timer_sleep (1);
+      counter = c + 1;
+      ceiling_lock_release (&ceiling_lock);
+      if (thread_get_priority () != PRI_DEFAULT)
+        fail ("priority %d after release, expected %d",
+              thread_get_priority (), PRI_DEFAULT);
+    }
+  sema_up (&done);
+}
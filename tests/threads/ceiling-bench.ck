@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(ceiling-bench) begin',
+		qr/\(ceiling-bench\) Donating lock: \d+ cycles per critical section\./,
+		qr/\(ceiling-bench\) Ceiling lock: \d+ cycles per critical section\./,
+		'(ceiling-bench) PASS',
+		'(ceiling-bench) end');
+pass;
@@ -0,0 +1,69 @@
+/* Checks admission control for the earliest-deadline-first
+   class.  Each request is made by its own thread, which keeps its
+   reservation until the main thread releases it.  Requests that
+   would reserve more than 95% of the CPU are refused, and the
+   bandwidth of a thread that exits is given back. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct request 
+  {
+    int64_t runtime, period, deadline;
+    struct semaphore release;
+  };
+
+#define REQUEST(R, P, D) {.runtime = (R), .period = (P), .deadline = (D)}
+static struct request requests[] = 
+  {
+    REQUEST (5, 10, 10), REQUEST (4, 10, 10), REQUEST (1, 10, 10),
+    REQUEST (1, 20, 20), REQUEST (2, 10, 5), REQUEST (2, 10, 5),
+  };
+
+static thread_func requester;
+static void request (int);
+
+void
+test_edf_admit (void) 
+{
+  size_t i;
+
+  for (i = 0; i < sizeof requests / sizeof *requests; i++)
+    sema_init (&requests[i].release, 0);
+
+  request (0);
+  request (1);
+  request (2);
+  request (3);
+  request (4);
+
+  msg ("Releasing 5/10/10.");
+  sema_up (&requests[0].release);
+  request (5);
+
+  for (i = 1; i < sizeof requests / sizeof *requests; i++)
+    sema_up (&requests[i].release);
+}
+
+/* Makes request I from a new thread, which runs until it has
+   asked for its reservation. */
+static void
+request (int i) 
+{
+  thread_create ("requester", PRI_DEFAULT + 1, requester, &requests[i]);
+}
+
+static void
+requester (void *r_) 
+{
+  struct request *r = r_;
+  bool admitted = thread_set_edf (r->runtime, r->period, r->deadline);
+
+  msg ("%lld/%lld/%lld: %s.", r->runtime, r->period, r->deadline,
+       admitted ? "admitted" : "refused");
+  if (admitted)
+    sema_down (&r->release);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-admit) begin
+(edf-admit) 5/10/10: admitted.
+(edf-admit) 4/10/10: admitted.
+(edf-admit) 1/10/10: refused.
+(edf-admit) 1/20/20: admitted.
+(edf-admit) 2/10/5: refused.
+(edf-admit) Releasing 5/10/10.
+(edf-admit) 2/10/5: admitted.
+(edf-admit) end
+EOF
+pass;
@@ -0,0 +1,145 @@
+/* Runs four periodic threads, reserving 80% of the CPU between
+   them, next to four batch threads that spin at nearly the
+   highest priority, first with the periodic threads in the EDF
+   class and then with them as plain threads at the batch
+   threads' priority.  Reports the deadlines missed by the
+   periodic threads and the work done by the batch threads in each
+   round.  No periodic job may miss its deadline under EDF. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define ROUND_TICKS 400         /* Length of each round. */
+#define BATCH_CNT 4             /* Number of batch threads. */
+#define BATCH_PRI (PRI_MAX - 1) /* Priority of the batch threads. */
+
+struct periodic 
+  {
+    int64_t runtime, period, deadline;
+    int jobs;                   /* Jobs completed. */
+    int misses;                 /* Jobs that ended late. */
+  };
+
+#define PERIODIC(R, P, D) {.runtime = (R), .period = (P), .deadline = (D)}
+static struct periodic periodics[] = 
+  {
+    PERIODIC (1, 5, 5), PERIODIC (2, 10, 10), PERIODIC (4, 20, 20),
+    PERIODIC (6, 30, 30),
+  };
+#define PERIODIC_CNT ((int) (sizeof periodics / sizeof *periodics))
+
+static struct semaphore done;
+static bool use_edf;
+static int64_t end_tick;
+static long long loops_per_tick;
+static long long batch_loops;
+
+static thread_func periodic_func, batch_func;
+static void run_round (bool edf);
+static void spin (long long loops);
+
+void
+test_edf_bench (void) 
+{
+  int64_t start;
+  long long loops = 0;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+
+  /* Calibrate the periodic threads' busy work. */
+  start = timer_ticks ();
+  while (timer_ticks () == start)
+    continue;
+  start = timer_ticks ();
+  while (timer_ticks () < start + 10)
+    loops++;
+  loops_per_tick = loops / 10;
+
+  run_round (true);
+  run_round (false);
+  pass ();
+}
+
+/* Runs the periodic and batch threads for ROUND_TICKS, with the
+   periodic threads in the EDF class if EDF, and reports. */
+static void
+run_round (bool edf) 
+{
+  int jobs = 0, misses = 0;
+  int i;
+
+  use_edf = edf;
+  batch_loops = 0;
+  end_tick = timer_ticks () + ROUND_TICKS;
+  for (i = 0; i < PERIODIC_CNT; i++) 
+    {
+      periodics[i].jobs = periodics[i].misses = 0;
+      thread_create ("periodic", BATCH_PRI, periodic_func, &periodics[i]);
+    }
+  for (i = 0; i < BATCH_CNT; i++)
+    thread_create ("batch", BATCH_PRI, batch_func, NULL);
+  for (i = 0; i < PERIODIC_CNT + BATCH_CNT; i++)
+    sema_down (&done);
+
+  for (i = 0; i < PERIODIC_CNT; i++) 
+    {
+      jobs += periodics[i].jobs;
+      misses += periodics[i].misses;
+    }
+  msg ("%s: %d of %d jobs missed their deadline, batch threads did "
+       "%lld loops.", edf ? "EDF" : "Priority", misses, jobs, batch_loops);
+  if (edf && misses != 0)
+    fail ("EDF missed %d deadlines", misses);
+}
+
+/* Periodic thread.  Each job does all but one tick's worth of
+   its runtime in busy work, then sleeps until the next period. */
+static void
+periodic_func (void *p_) 
+{
+  struct periodic *p = p_;
+  int64_t release = timer_ticks ();
+
+  if (use_edf && !thread_set_edf (p->runtime, p->period, p->deadline))
+    fail ("admission refused");
+  while (release + p->period <= end_tick) 
+    {
+      spin ((p->runtime - 1) * loops_per_tick);
+      if (timer_ticks () > release + p->deadline)
+        p->misses++;
+      p->jobs++;
+
+      release += p->period;
+      if (use_edf)
+        thread_edf_yield ();
+      else if (release > timer_ticks ())
+        timer_sleep (release - timer_ticks ());
+    }
+  if (use_edf)
+    thread_clear_edf ();
+  sema_up (&done);
+}
+
+/* Batch thread.  Spins until the end of the round. */
+static void
+batch_func (void *aux UNUSED) 
+{
+  while (timer_ticks () < end_tick)
+    batch_loops++;
+  sema_up (&done);
+}
+
+/* Does LOOPS iterations of busy work. */
+static void
+spin (long long loops) 
+{
+  while (loops-- > 0)
+    barrier ();
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(edf-bench) begin',
+		qr/\(edf-bench\) EDF: 0 of \d+ jobs missed their deadline, batch threads did \d+ loops\./,
+		qr/\(edf-bench\) Priority: \d+ of \d+ jobs missed their deadline, batch threads did \d+ loops\./,
+		'(edf-bench) PASS',
+		'(edf-bench) end');
+pass;
@@ -0,0 +1,123 @@
+/* Runs three periodic EDF threads next to a fourth EDF thread
+   that never finishes a job and four batch threads that spin at
+   nearly the highest priority.  The periodic threads reserve 60%
+   of the CPU and each job uses all but one tick of its runtime.
+   EDF must run them ahead of the batch threads, and must throttle
+   the overrunning thread once its budget is gone, so that no
+   periodic job ends after its deadline. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define JOB_CNT 20              /* Jobs per periodic thread. */
+#define BATCH_CNT 4             /* Number of batch threads. */
+
+struct periodic 
+  {
+    int64_t runtime, period, deadline;
+    unsigned misses;            /* Deadlines missed. */
+    int jobs;                   /* Jobs completed. */
+  };
+
+#define PERIODIC(R, P, D) {.runtime = (R), .period = (P), .deadline = (D)}
+static struct periodic periodics[] = 
+  {
+    PERIODIC (2, 10, 10), PERIODIC (3, 15, 15), PERIODIC (2, 20, 10),
+  };
+#define PERIODIC_CNT ((int) (sizeof periodics / sizeof *periodics))
+
+static struct semaphore done;
+static int64_t end_tick;
+static unsigned overruns;
+static long long batch_loops;
+
+static thread_func periodic_func, overrun_func, batch_func;
+static void spin_budget (int64_t ticks);
+
+void
+test_edf_miss (void) 
+{
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+  end_tick = timer_ticks () + JOB_CNT * 20 + 20;
+
+  for (i = 0; i < PERIODIC_CNT; i++)
+    thread_create ("periodic", PRI_DEFAULT, periodic_func, &periodics[i]);
+  thread_create ("overrun", PRI_DEFAULT, overrun_func, NULL);
+  for (i = 0; i < BATCH_CNT; i++)
+    thread_create ("batch", PRI_MAX - 1, batch_func, NULL);
+
+  for (i = 0; i < PERIODIC_CNT + 1 + BATCH_CNT; i++)
+    sema_down (&done);
+
+  for (i = 0; i < PERIODIC_CNT; i++) 
+    {
+      struct periodic *p = &periodics[i];
+      msg ("%lld/%lld/%lld: %d jobs, %u missed their deadline.",
+           p->runtime, p->period, p->deadline, p->jobs, p->misses);
+    }
+  msg ("Overrunning thread was throttled: %s.",
+       overruns > 0 ? "yes" : "no");
+  msg ("Batch threads ran: %s.", batch_loops > 0 ? "yes" : "no");
+}
+
+/* Completes JOB_CNT jobs, each using all but one tick of its
+   runtime. */
+static void
+periodic_func (void *p_) 
+{
+  struct periodic *p = p_;
+
+  if (!thread_set_edf (p->runtime, p->period, p->deadline))
+    fail ("admission refused");
+  for (p->jobs = 0; p->jobs < JOB_CNT; p->jobs++) 
+    {
+      spin_budget (p->runtime - 1);
+      thread_edf_yield ();
+    }
+  p->misses = thread_current ()->edf_misses;
+  thread_clear_edf ();
+  sema_up (&done);
+}
+
+/* Asks for 1 tick in 10 but spins until the end of the test. */
+static void
+overrun_func (void *aux UNUSED) 
+{
+  if (!thread_set_edf (1, 10, 10))
+    fail ("admission refused");
+  while (timer_ticks () < end_tick)
+    continue;
+  overruns = thread_current ()->edf_overruns;
+  thread_clear_edf ();
+  sema_up (&done);
+}
+
+/* Spins until the end of the test. */
+static void
+batch_func (void *aux UNUSED) 
+{
+  while (timer_ticks () < end_tick)
+    batch_loops++;
+  sema_up (&done);
+}
+
+/* Spins until TICKS more ticks have been charged to the running
+   thread's EDF budget. */
+static void
+spin_budget (int64_t ticks) 
+{
+  struct thread *t = thread_current ();
+  int64_t target = t->edf_budget - ticks;
+
+  while (t->edf_budget > target)
+    barrier ();
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-miss) begin
+(edf-miss) 2/10/10: 20 jobs, 0 missed their deadline.
+(edf-miss) 3/15/15: 20 jobs, 0 missed their deadline.
+(edf-miss) 2/20/10: 20 jobs, 0 missed their deadline.
+(edf-miss) Overrunning thread was throttled: yes.
+(edf-miss) Batch threads ran: yes.
+(edf-miss) end
+EOF
+pass;
@@ -0,0 +1,89 @@
+/* Bounces control between two threads through a pair of
+   semaphores, as switch-pingpong does, first with ordinary
+   semaphores and then with directed handoff turned on, and with
+   the ponger at the same priority as the pinger and then at a
+   higher one.  Reports the average TSC cycles per round trip for
+   each, and checks that the two threads really alternate. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define ROUND_TRIPS 100000      /* Number of round trips per run. */
+
+static struct semaphore ping, pong, done;
+static int turn;
+
+static thread_func ponger;
+static void bounce (int priority, bool handoff);
+
+void
+test_handoff_pingpong (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  bounce (PRI_DEFAULT, false);
+  bounce (PRI_DEFAULT, true);
+  bounce (PRI_DEFAULT + 1, false);
+  bounce (PRI_DEFAULT + 1, true);
+  pass ();
+}
+
+/* Bounces ROUND_TRIPS times with a ponger at PRIORITY, with
+   handoff on both semaphores if HANDOFF is true. */
+static void
+bounce (int priority, bool handoff) 
+{
+  uint64_t start, cycles;
+  int i;
+
+  sema_init (&ping, 0);
+  sema_init (&pong, 0);
+  sema_init (&done, 0);
+  sema_set_handoff (&ping, handoff);
+  sema_set_handoff (&pong, handoff);
+  turn = 0;
+  thread_create ("ponger", priority, ponger, NULL);
+
+  /* Let the ponger run up to its first sema_down(), so that the
+     timed loop only ever switches between two running threads. */
+  sema_up (&ping);
+  sema_down (&pong);
+
+  start = rdtsc ();
+  for (i = 0; i < ROUND_TRIPS; i++) 
+    {
+      if (turn != 2 * i + 1)
+        fail ("pinger out of turn at round trip %d", i);
+      turn++;
+      sema_up (&ping);
+      sema_down (&pong);
+    }
+  cycles = rdtsc () - start;
+  sema_down (&done);
+
+  msg ("Ponger priority %d, handoff %s: %llu cycles per round trip.",
+       priority, handoff ? "on" : "off",
+       (unsigned long long) (cycles / ROUND_TRIPS));
+}
+
+/* Answers every ping with a pong. */
+static void
+ponger (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i <= ROUND_TRIPS; i++) 
+    {
+      sema_down (&ping);
+      if (turn != 2 * i)
+        fail ("ponger out of turn at round trip %d", i);
+      turn++;
+      sema_up (&pong);
+    }
+  sema_up (&done);
+}
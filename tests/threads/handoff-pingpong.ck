@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(handoff-pingpong) begin',
+		qr/\(handoff-pingpong\) Ponger priority 31, handoff off: \d+ cycles per round trip\./,
+		qr/\(handoff-pingpong\) Ponger priority 31, handoff on: \d+ cycles per round trip\./,
+		qr/\(handoff-pingpong\) Ponger priority 32, handoff off: \d+ cycles per round trip\./,
+		qr/\(handoff-pingpong\) Ponger priority 32, handoff on: \d+ cycles per round trip\./,
+		'(handoff-pingpong) PASS',
+		'(handoff-pingpong) end');
+pass;
@@ -0,0 +1,45 @@
+/* Turns on the interrupts-off profiler, keeps interrupts off for
+   a known number of TSC cycles, and checks that the profiler saw
+   a window at least that long.  Nested intr_disable() calls
+   inside the window must not split it.  Then dumps the profile,
+   which also covers the timer interrupts and thread switches of
+   a short sleep. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+
+#define SPIN_CYCLES 1000000     /* Length of the window. */
+
+void
+test_intr_profile (void) 
+{
+  bool was_profiling = intr_profile;
+  enum intr_level old_level;
+  uint64_t start;
+
+  intr_profile = true;
+  intr_profile_reset ();
+
+  old_level = intr_disable ();
+  start = rdtsc ();
+  while (rdtsc () - start < SPIN_CYCLES / 2)
+    continue;
+  intr_set_level (intr_disable ());
+  while (rdtsc () - start < SPIN_CYCLES)
+    continue;
+  intr_set_level (old_level);
+
+  if (intr_off_max_cycles () < SPIN_CYCLES)
+    fail ("longest window %llu cycles, expected at least %d",
+          (unsigned long long) intr_off_max_cycles (), SPIN_CYCLES);
+  msg ("Saw the interrupts-off window.");
+
+  timer_sleep (5);
+  intr_dump_profile ();
+  intr_profile = was_profiling;
+  pass ();
+}
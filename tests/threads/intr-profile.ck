@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(intr-profile) begin',
+		'(intr-profile) Saw the interrupts-off window.',
+		qr/Interrupts-off windows at \d+ sites(, \d+ more windows dropped)?:/,
+		qr/ +site +windows +total cycles +max cycles/,
+		[qr/  0x[0-9a-f]{16} +\d+ +\d+ +\d+|    2\^\d+:\d+( 2\^\d+:\d+)*/],
+		'Interrupt handlers:',
+		qr/ +vec +name +count +cycles/,
+		[qr/  0x[0-9a-f]{2} .* +\d+ +\d+/],
+		qr/Sites:( 0x[0-9a-f]+)+\./,
+		'(intr-profile) PASS',
+		'(intr-profile) end');
+pass;
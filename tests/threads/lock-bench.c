@@ -0,0 +1,95 @@
+/* Measures the cost of uncontended lock acquire/release pairs and
+   semaphore down/up pairs, next to that of turning interrupts off
+   and back on, which the slow paths do at least once per
+   operation.  Then has two threads hand a lock back and forth,
+   which always takes the slow path, and checks that no update
+   under the lock is lost. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define ITER_CNT 100000         /* Uncontended pairs to time. */
+#define HANDOFF_CNT 2000        /* Contended critical sections per thread. */
+
+static struct lock lock;
+static struct semaphore sema;
+static struct semaphore done;
+static int counter;
+
+static thread_func contender;
+
+void
+test_lock_bench (void) 
+{
+  uint64_t start, intr_cycles, lock_cycles, sema_cycles, handoff_cycles;
+  int i;
+
+  lock_init (&lock);
+  sema_init (&sema, 1);
+  sema_init (&done, 0);
+
+  start = rdtsc ();
+  for (i = 0; i < ITER_CNT; i++)
+    intr_set_level (intr_disable ());
+  intr_cycles = rdtsc () - start;
+
+  start = rdtsc ();
+  for (i = 0; i < ITER_CNT; i++) 
+    {
+      lock_acquire (&lock);
+      lock_release (&lock);
+    }
+  lock_cycles = rdtsc () - start;
+
+  start = rdtsc ();
+  for (i = 0; i < ITER_CNT; i++) 
+    {
+      sema_down (&sema);
+      sema_up (&sema);
+    }
+  sema_cycles = rdtsc () - start;
+
+  msg ("Interrupts off and on: %llu cycles.",
+       (unsigned long long) (intr_cycles / ITER_CNT));
+  msg ("Uncontended lock acquire and release: %llu cycles.",
+       (unsigned long long) (lock_cycles / ITER_CNT));
+  msg ("Uncontended semaphore down and up: %llu cycles.",
+       (unsigned long long) (sema_cycles / ITER_CNT));
+
+  start = rdtsc ();
+  thread_create ("contender", PRI_DEFAULT, contender, NULL);
+  contender (NULL);
+  sema_down (&done);
+  handoff_cycles = rdtsc () - start;
+  msg ("Contended lock, 2 threads: %llu cycles per critical section.",
+       (unsigned long long) (handoff_cycles / (2 * HANDOFF_CNT)));
+
+  if (counter != 2 * HANDOFF_CNT)
+    fail ("counter is %d, expected %d", counter, 2 * HANDOFF_CNT);
+  pass ();
+}
+
+/* Increments the counter HANDOFF_CNT times, yielding while
+   holding the lock so that the other thread finds it held. */
+static void
+contender (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < HANDOFF_CNT; i++) 
+    {
+      int c;
+
+      lock_acquire (&lock);
+      c = counter;
+      thread_yield ();
+      counter = c + 1;
+      lock_release (&lock);
+    }
+  sema_up (&done);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(lock-bench) begin',
+		qr/\(lock-bench\) Interrupts off and on: \d+ cycles\./,
+		qr/\(lock-bench\) Uncontended lock acquire and release: \d+ cycles\./,
+		qr/\(lock-bench\) Uncontended semaphore down and up: \d+ cycles\./,
+		qr/\(lock-bench\) Contended lock, 2 threads: \d+ cycles per critical section\./,
+		'(lock-bench) PASS',
+		'(lock-bench) end');
+pass;
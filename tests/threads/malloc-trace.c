@@ -0,0 +1,111 @@
+/* Replays a mixed-size allocation trace through malloc() and
+   free(), checking that blocks keep their contents, and reports
+   throughput and internal fragmentation.  Also checks that
+   realloc() resizes a block in place when the new size fits. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <random.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "intrinsic.h"
+
+#define SLOT_CNT 256            /* Blocks live at once. */
+#define STEP_CNT 50000          /* Allocations in the trace. */
+
+struct slot {
+  uint8_t *p;                   /* Block, or null. */
+  size_t size;                  /* Requested size. */
+};
+
+static struct slot slots[SLOT_CNT];
+
+/* Returns a request size for the trace: mostly small objects,
+   with a tail of larger ones up to 2 kB. */
+static size_t
+trace_size (void) 
+{
+  unsigned long r = random_ulong ();
+
+  switch (r % 8)
+    {
+    case 0: case 1: case 2: case 3:
+      return 1 + (r >> 3) % 64;
+    case 4: case 5: case 6:
+      return 65 + (r >> 3) % 448;
+    default:
+      return 513 + (r >> 3) % 1536;
+    }
+}
+
+/* Checks that the block in S still holds its fill pattern and
+   frees it. */
+static void
+release (struct slot *s) 
+{
+  size_t i;
+
+  if (s->p == NULL)
+    return;
+  for (i = 0; i < s->size; i++)
+    if (s->p[i] != (uint8_t) s->size)
+      fail ("block of %zu bytes corrupted at offset %zu", s->size, i);
+  free (s->p);
+  s->p = NULL;
+}
+
+void
+test_malloc_trace (void) 
+{
+  uint64_t requested = 0, usable = 0, start, cycles;
+  uintptr_t old;
+  void *p, *q;
+  int step;
+
+  random_init (0x5eed);
+
+  start = rdtsc ();
+  for (step = 0; step < STEP_CNT; step++) 
+    {
+      struct slot *s = &slots[random_ulong () % SLOT_CNT];
+
+      release (s);
+      s->size = trace_size ();
+      s->p = malloc (s->size);
+      if (s->p == NULL)
+        fail ("malloc (%zu) failed", s->size);
+      memset (s->p, (uint8_t) s->size, s->size);
+
+      requested += s->size;
+      usable += malloc_usable_size (s->p);
+    }
+  for (step = 0; step < SLOT_CNT; step++)
+    release (&slots[step]);
+  cycles = rdtsc () - start;
+
+  if (usable < requested)
+    fail ("usable size %llu below requested %llu",
+          (unsigned long long) usable, (unsigned long long) requested);
+
+  /* Growing within the block's size class must not move it. */
+  p = malloc (20);
+  if (p == NULL)
+    fail ("malloc (20) failed");
+  memset (p, 0x5a, 20);
+  old = (uintptr_t) p;
+  p = realloc (p, malloc_usable_size (p));
+  if ((uintptr_t) p != old)
+    fail ("realloc within block moved it");
+  q = realloc (p, malloc_usable_size (p) + 1);
+  if (q == NULL || ((uint8_t *) q)[19] != 0x5a)
+    fail ("realloc to larger block lost contents");
+  free (q);
+
+  msg ("%d allocations, %llu cycles per allocate/free pair.",
+       STEP_CNT, (unsigned long long) (cycles / STEP_CNT));
+  msg ("Internal fragmentation: %llu.%llu%% of usable bytes.",
+       (unsigned long long) ((usable - requested) * 100 / usable),
+       (unsigned long long) ((usable - requested) * 1000 / usable % 10));
+  pass ();
+}
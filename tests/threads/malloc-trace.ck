@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(malloc-trace) begin',
+		qr/\(malloc-trace\) 50000 allocations, \d+ cycles per allocate\/free pair\./,
+		qr/\(malloc-trace\) Internal fragmentation: \d+\.\d% of usable bytes\./,
+		'(malloc-trace) PASS',
+		'(malloc-trace) end');
+pass;
@@ -135,7 +135,7 @@ test_mlfqs_load_avg (void)
     {
       char name[16];
       snprintf(name, sizeof name, "load %d", i);
-      thread_create (name, PRI_DEFAULT, load_thread, (void *) i);
+      thread_create (name, PRI_DEFAULT, load_thread, (void *) (intptr_t) i);
     }
   msg ("Starting threads took %d seconds.",
        timer_elapsed (start_time) / TIMER_FREQ);
@@ -155,7 +155,7 @@ test_mlfqs_load_avg (void)
 static void
 load_thread (void *seq_no_) 
 {
-  int seq_no = (int) seq_no_;
+  int seq_no = (intptr_t) seq_no_;
   int sleep_time = TIMER_FREQ * (10 + seq_no);
   int spin_time = sleep_time + TIMER_FREQ * THREAD_CNT;
   int exit_time = TIMER_FREQ * (THREAD_CNT * 2);
@@ -0,0 +1,82 @@
+/* Times single-page and 8-page allocate/free pairs from the user
+   pool, first while it is all free and then while all of it but
+   one 64-page block is in use, and prints the pool's free blocks
+   in both states.  With a buddy allocator the two should cost
+   about the same.  Run with 512 MB of memory, so that the user
+   pool has 256 MB. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+#define ITER_CNT 10000          /* Pairs to time. */
+#define SLACK_PAGES 64          /* Pages left free in the full pool. */
+
+static uint64_t time_pairs (size_t page_cnt);
+
+void
+test_palloc_bench (void) 
+{
+  void *full = NULL;
+  void *slack;
+  size_t filled = 0;
+  uint64_t one, eight;
+
+  one = time_pairs (1);
+  eight = time_pairs (8);
+  msg ("Empty pool: %llu cycles per 1-page pair, %llu per 8-page pair.",
+       (unsigned long long) one, (unsigned long long) eight);
+  palloc_print_stats ();
+
+  /* Fill the pool but for one block, chaining the pages through
+     their first words. */
+  slack = palloc_get_multiple (PAL_USER, SLACK_PAGES);
+  if (slack == NULL)
+    fail ("could not allocate %d pages", SLACK_PAGES);
+  for (;;) 
+    {
+      void **page = palloc_get_page (PAL_USER);
+      if (page == NULL)
+        break;
+      *page = full;
+      full = page;
+      filled++;
+    }
+  palloc_free_multiple (slack, SLACK_PAGES);
+
+  one = time_pairs (1);
+  eight = time_pairs (8);
+  msg ("Filled %zu pages.", filled);
+  msg ("Full pool: %llu cycles per 1-page pair, %llu per 8-page pair.",
+       (unsigned long long) one, (unsigned long long) eight);
+  palloc_print_stats ();
+
+  while (full != NULL) 
+    {
+      void **page = full;
+      full = *page;
+      palloc_free_page (page);
+    }
+  pass ();
+}
+
+/* Returns the average cycles to allocate PAGE_CNT user pages and
+   free them again. */
+static uint64_t
+time_pairs (size_t page_cnt) 
+{
+  uint64_t start = rdtsc ();
+  int i;
+
+  for (i = 0; i < ITER_CNT; i++) 
+    {
+      void *pages = palloc_get_multiple (PAL_USER, page_cnt);
+      if (pages == NULL)
+        fail ("could not allocate %zu pages", page_cnt);
+      palloc_free_multiple (pages, page_cnt);
+    }
+  return (rdtsc () - start) / ITER_CNT;
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+my (@stats);
+for my $pool ('kernel', 'user') {
+    push (@stats,
+	  qr/Palloc: $pool pool free blocks by order:( \d+)+/,
+	  qr/Palloc: $pool pool \d+ pages free, largest block \d+, \d+% fragmented/,
+	  qr/Palloc: $pool pool \d+ pages in use, peak \d+/);
+}
+push (@stats, qr/Palloc: \d+ zeroed pages preset, \d+ zeroed on demand/);
+check_patterns ('(palloc-bench) begin',
+		qr/\(palloc-bench\) Empty pool: \d+ cycles per 1-page pair, \d+ per 8-page pair\./,
+		@stats,
+		qr/\(palloc-bench\) Filled \d+ pages\./,
+		qr/\(palloc-bench\) Full pool: \d+ cycles per 1-page pair, \d+ per 8-page pair\./,
+		@stats,
+		'(palloc-bench) PASS',
+		'(palloc-bench) end');
+pass;
@@ -0,0 +1,82 @@
+/* Measures single-page PAL_ZERO allocations from each pool, first
+   after sleeping long enough for the idle thread to stock up on
+   zeroed pages, then again once the stock has run out so that
+   every page must be zeroed on demand.  Checks that every page
+   handed out is really zero. */
+
+#include <stdint.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+
+#define PAGE_CNT 256            /* Pages to allocate from each pool. */
+
+static void *pages[PAGE_CNT];
+
+static void measure (const char *name, enum palloc_flags flags);
+
+void
+test_palloc_zero (void) 
+{
+  measure ("kernel", PAL_ZERO);
+  measure ("user", PAL_ZERO | PAL_USER);
+  pass ();
+}
+
+/* Allocates PAGE_CNT pages with FLAGS and reports the average
+   cost of those that came from the zeroed stock and of those
+   that did not. */
+static void
+measure (const char *name, enum palloc_flags flags) 
+{
+  uint64_t hit_cycles = 0, miss_cycles = 0;
+  uint64_t hits = 0, misses = 0;
+  int i;
+
+  /* Let the idle thread refill the stock. */
+  timer_msleep (200);
+
+  for (i = 0; i < PAGE_CNT; i++) 
+    {
+      uint64_t h0, m0, h1, m1, start, cycles;
+      uint64_t *word;
+
+      palloc_zero_stats (&h0, &m0);
+      start = rdtsc ();
+      pages[i] = palloc_get_page (flags);
+      cycles = rdtsc () - start;
+      palloc_zero_stats (&h1, &m1);
+      if (pages[i] == NULL)
+        fail ("%s pool: out of pages after %d", name, i);
+
+      if (h1 > h0) 
+        {
+          hits++;
+          hit_cycles += cycles;
+        }
+      else
+        {
+          misses++;
+          miss_cycles += cycles;
+        }
+
+      for (word = pages[i]; word < (uint64_t *) pages[i] + PGSIZE / 8; word++)
+        if (*word != 0)
+          fail ("%s pool: page %d not zeroed", name, i);
+    }
+
+  for (i = 0; i < PAGE_CNT; i++)
+    palloc_free_page (pages[i]);
+
+  if (hits == 0)
+    fail ("%s pool: no pre-zeroed pages", name);
+  if (misses == 0)
+    fail ("%s pool: stock never ran out", name);
+  msg ("%s pool: %llu pre-zeroed, %llu cycles each; "
+       "%llu zeroed on demand, %llu cycles each.", name,
+       (unsigned long long) hits, (unsigned long long) (hit_cycles / hits),
+       (unsigned long long) misses,
+       (unsigned long long) (miss_cycles / misses));
+}
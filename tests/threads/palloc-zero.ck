@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(palloc-zero) begin',
+		qr/\(palloc-zero\) kernel pool: \d+ pre-zeroed, \d+ cycles each; \d+ zeroed on demand, \d+ cycles each\./,
+		qr/\(palloc-zero\) user pool: \d+ pre-zeroed, \d+ cycles each; \d+ zeroed on demand, \d+ cycles each\./,
+		'(palloc-zero) PASS',
+		'(palloc-zero) end');
+pass;
@@ -0,0 +1,135 @@
+/* Stresses priority donation in two ways and reports what it
+   costs.
+
+   First, 128 threads at priorities above the main thread's block
+   on a lock the main thread holds.  The main thread must end up
+   at the highest of their priorities.  When it releases the lock,
+   the waiters must get it in order of priority, each one handing
+   it to the next.  Reports the cycles per handoff.
+
+   Second, the main thread holds the first lock of a chain as long
+   as the donation depth limit, in which each thread holds one lock
+   and waits for the previous one.  Each new thread at the end of
+   the chain must raise the main thread to its own priority.
+   Reports the cycles from the last thread's lock_acquire() to the
+   main thread running at the donated priority. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define WAITER_CNT 128          /* Number of waiters on one lock. */
+#define CHAIN_MAX 32            /* Longest chain tested. */
+
+static thread_func waiter_func;
+static thread_func chain_func;
+
+static struct lock hot_lock;
+static int handoff_cnt;
+static int last_priority;
+static bool out_of_order;
+
+struct chain_link
+  {
+    struct lock *mine;          /* Lock to hold, or null. */
+    struct lock *wait;          /* Lock to wait for. */
+  };
+
+/* Static, because they would not fit on the kernel stack. */
+static struct lock locks[CHAIN_MAX];
+static struct chain_link links[CHAIN_MAX + 1];
+static uint64_t chain_start;
+
+void
+test_priority_donate_stress (void) 
+{
+  uint64_t start, cycles;
+  int depth;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Many waiters on one lock. */
+  lock_init (&hot_lock);
+  lock_acquire (&hot_lock);
+  for (i = 0; i < WAITER_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "waiter %d", i);
+      thread_create (name, PRI_DEFAULT + 1 + i % (PRI_MAX - PRI_DEFAULT),
+                     waiter_func, NULL);
+    }
+  msg ("%d waiters blocked; main priority %d.", WAITER_CNT,
+       thread_get_priority ());
+  if (thread_get_priority () != PRI_MAX)
+    fail ("main thread should have priority %d", PRI_MAX);
+
+  last_priority = PRI_MAX;
+  start = rdtsc ();
+  lock_release (&hot_lock);
+  cycles = rdtsc () - start;
+  if (handoff_cnt != WAITER_CNT)
+    fail ("only %d of %d waiters got the lock", handoff_cnt, WAITER_CNT);
+  if (out_of_order)
+    fail ("waiters got the lock out of priority order");
+  msg ("%llu cycles per lock handoff.",
+       (unsigned long long) (cycles / WAITER_CNT));
+
+  /* A donation chain as deep as donations go. */
+  depth = donate_depth < CHAIN_MAX ? donate_depth : CHAIN_MAX;
+  if (depth > PRI_MAX - PRI_MIN)
+    depth = PRI_MAX - PRI_MIN;
+  thread_set_priority (PRI_MIN);
+  for (i = 0; i < depth; i++)
+    lock_init (&locks[i]);
+  lock_acquire (&locks[0]);
+  for (i = 1; i <= depth; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "chain %d", i);
+      links[i].mine = i < depth ? &locks[i] : NULL;
+      links[i].wait = &locks[i - 1];
+      thread_create (name, PRI_MIN + i, chain_func, &links[i]);
+      if (thread_get_priority () != PRI_MIN + i)
+        fail ("after %d links main has priority %d, not %d",
+              i, thread_get_priority (), PRI_MIN + i);
+    }
+  cycles = rdtsc () - chain_start;
+  msg ("Donation through %d locks: %llu cycles.", depth,
+       (unsigned long long) cycles);
+  lock_release (&locks[0]);
+  thread_set_priority (PRI_DEFAULT);
+  pass ();
+}
+
+/* Takes the hot lock, checking that no higher-priority waiter
+   was passed over, and hands it on. */
+static void
+waiter_func (void *aux UNUSED) 
+{
+  lock_acquire (&hot_lock);
+  if (thread_get_priority () > last_priority)
+    out_of_order = true;
+  last_priority = thread_get_priority ();
+  handoff_cnt++;
+  lock_release (&hot_lock);
+}
+
+/* Holds its own lock, if any, and waits for the previous one. */
+static void
+chain_func (void *link_) 
+{
+  struct chain_link *link = link_;
+
+  if (link->mine != NULL)
+    lock_acquire (link->mine);
+  chain_start = rdtsc ();
+  lock_acquire (link->wait);
+  lock_release (link->wait);
+  if (link->mine != NULL)
+    lock_release (link->mine);
+}
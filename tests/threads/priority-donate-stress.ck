@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(priority-donate-stress) begin',
+		'(priority-donate-stress) 128 waiters blocked; main priority 63.',
+		qr/\(priority-donate-stress\) \d+ cycles per lock handoff\./,
+		qr/\(priority-donate-stress\) Donation through \d+ locks: \d+ cycles\./,
+		'(priority-donate-stress) PASS',
+		'(priority-donate-stress) end');
+pass;
@@ -0,0 +1,111 @@
+/* Checks that a thread that receives a priority donation while it
+   waits on a semaphore or condition variable is woken according
+   to its new priority.
+
+   Thread "low" (priority 32) takes a lock and waits, then thread
+   "high" (priority 33) waits, then thread "donor" (priority 40)
+   blocks on low's lock, raising low to 40.  The first wakeup must
+   go to low.  This is done once with a semaphore and once with a
+   condition variable. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static struct semaphore sema;
+static struct lock cond_lock;
+static struct condition cond;
+static struct lock held;
+static bool use_cond;
+
+static thread_func low_func, high_func, donor_func;
+static void wait_once (const char *name);
+static void run_round (bool);
+
+void
+test_priority_waitq (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  sema_init (&sema, 0);
+  lock_init (&cond_lock);
+  cond_init (&cond);
+  lock_init (&held);
+
+  run_round (false);
+  run_round (true);
+}
+
+static void
+run_round (bool cond_) 
+{
+  use_cond = cond_;
+  msg ("Waiting on a %s.", use_cond ? "condition variable" : "semaphore");
+  thread_create ("low", PRI_DEFAULT + 1, low_func, NULL);
+  thread_create ("high", PRI_DEFAULT + 2, high_func, NULL);
+  thread_create ("donor", PRI_DEFAULT + 9, donor_func, NULL);
+
+  msg ("main: waking one thread.");
+  if (use_cond) 
+    {
+      lock_acquire (&cond_lock);
+      cond_signal (&cond, &cond_lock);
+      lock_release (&cond_lock);
+    }
+  else
+    sema_up (&sema);
+
+  msg ("main: waking another thread.");
+  if (use_cond) 
+    {
+      lock_acquire (&cond_lock);
+      cond_signal (&cond, &cond_lock);
+      lock_release (&cond_lock);
+    }
+  else
+    sema_up (&sema);
+}
+
+/* Waits once on the semaphore or condition variable. */
+static void
+wait_once (const char *name) 
+{
+  msg ("%s: waiting.", name);
+  if (use_cond) 
+    {
+      lock_acquire (&cond_lock);
+      cond_wait (&cond, &cond_lock);
+      lock_release (&cond_lock);
+    }
+  else
+    sema_down (&sema);
+  msg ("%s: woke up with priority %d.", name, thread_get_priority ());
+}
+
+static void
+low_func (void *aux UNUSED) 
+{
+  lock_acquire (&held);
+  wait_once ("low");
+  lock_release (&held);
+}
+
+static void
+high_func (void *aux UNUSED) 
+{
+  wait_once ("high");
+}
+
+static void
+donor_func (void *aux UNUSED) 
+{
+  lock_acquire (&held);
+  msg ("donor: got the lock.");
+  lock_release (&held);
+}
@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-waitq) begin
+(priority-waitq) Waiting on a semaphore.
+(priority-waitq) low: waiting.
+(priority-waitq) high: waiting.
+(priority-waitq) main: waking one thread.
+(priority-waitq) low: woke up with priority 40.
+(priority-waitq) donor: got the lock.
+(priority-waitq) main: waking another thread.
+(priority-waitq) high: woke up with priority 33.
+(priority-waitq) Waiting on a condition variable.
+(priority-waitq) low: waiting.
+(priority-waitq) high: waiting.
+(priority-waitq) main: waking one thread.
+(priority-waitq) low: woke up with priority 40.
+(priority-waitq) donor: got the lock.
+(priority-waitq) main: waking another thread.
+(priority-waitq) high: woke up with priority 33.
+(priority-waitq) end
+EOF
+pass;
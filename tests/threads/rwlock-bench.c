@@ -0,0 +1,147 @@
+/* Runs 30 readers and 2 writers over a shared array, each
+   yielding in the middle of its critical section, first under a
+   reader-writer lock and then under a plain lock.  Checks that no
+   reader ever sees a half-written array, and reports the largest
+   number of readers seen inside at once and the cycles per
+   critical section under each. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define READER_CNT 30           /* Number of reader threads. */
+#define WRITER_CNT 2            /* Number of writer threads. */
+#define ITER_CNT 200            /* Critical sections per thread. */
+#define SLOT_CNT 16             /* Size of the shared array. */
+
+static int data[SLOT_CNT];
+static struct rwlock rw;
+static struct lock plain;
+static bool use_rwlock;
+static struct semaphore done;
+
+static int active_readers;
+static int max_readers;
+static int torn_reads;
+
+static thread_func reader_func;
+static thread_func writer_func;
+static uint64_t run_round (bool);
+
+void
+test_rwlock_bench (void) 
+{
+  uint64_t rw_cycles, lock_cycles;
+  int sections = (READER_CNT + WRITER_CNT) * ITER_CNT;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  rwlock_init (&rw);
+  lock_init (&plain);
+  sema_init (&done, 0);
+
+  msg ("%d readers and %d writers, %d critical sections each.",
+       READER_CNT, WRITER_CNT, ITER_CNT);
+  rw_cycles = run_round (true);
+  msg ("rwlock: %llu cycles per critical section, up to %d readers at once.",
+       (unsigned long long) (rw_cycles / sections), max_readers);
+  lock_cycles = run_round (false);
+  msg ("lock: %llu cycles per critical section.",
+       (unsigned long long) (lock_cycles / sections));
+
+  if (torn_reads != 0)
+    fail ("%d reads saw a partial write", torn_reads);
+  pass ();
+}
+
+/* Runs every reader and writer to completion, using a
+   reader-writer lock if USE_RW or a plain lock otherwise, and
+   returns the cycles it took. */
+static uint64_t
+run_round (bool use_rw) 
+{
+  uint64_t start;
+  int i;
+
+  use_rwlock = use_rw;
+  start = rdtsc ();
+  for (i = 0; i < READER_CNT + WRITER_CNT; i++) 
+    {
+      char name[16];
+      bool writer = i % (READER_CNT / WRITER_CNT + 1) == 0;
+
+      snprintf (name, sizeof name, "%s %d", writer ? "writer" : "reader", i);
+      thread_create (name, PRI_DEFAULT, writer ? writer_func : reader_func,
+                     NULL);
+    }
+  for (i = 0; i < READER_CNT + WRITER_CNT; i++)
+    sema_down (&done);
+  return rdtsc () - start;
+}
+
+static void
+reader_func (void *aux UNUSED) 
+{
+  int i, j;
+
+  for (i = 0; i < ITER_CNT; i++) 
+    {
+      int first;
+
+      if (use_rwlock)
+        rwlock_read_acquire (&rw);
+      else
+        lock_acquire (&plain);
+      if (++active_readers > max_readers)
+        max_readers = active_readers;
+
+      first = data[0];
+      thread_yield ();
+      for (j = 1; j < SLOT_CNT; j++)
+        if (data[j] != first)
+          {
+            torn_reads++;
+            break;
+          }
+
+      active_readers--;
+      if (use_rwlock)
+        rwlock_read_release (&rw);
+      else
+        lock_release (&plain);
+      thread_yield ();
+    }
+  sema_up (&done);
+}
+
+static void
+writer_func (void *aux UNUSED) 
+{
+  int i, j;
+
+  for (i = 0; i < ITER_CNT; i++) 
+    {
+      if (use_rwlock)
+        rwlock_write_acquire (&rw);
+      else
+        lock_acquire (&plain);
+
+      for (j = 0; j < SLOT_CNT; j++) 
+        {
+          data[j]++;
+          if (j == SLOT_CNT / 2)
+            thread_yield ();
+        }
+
+      if (use_rwlock)
+        rwlock_write_release (&rw);
+      else
+        lock_release (&plain);
+      thread_yield ();
+    }
+  sema_up (&done);
+}
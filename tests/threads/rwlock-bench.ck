@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(rwlock-bench) begin',
+		'(rwlock-bench) 30 readers and 2 writers, 200 critical sections each.',
+		qr/\(rwlock-bench\) rwlock: \d+ cycles per critical section, up to \d+ readers at once\./,
+		qr/\(rwlock-bench\) lock: \d+ cycles per critical section\./,
+		'(rwlock-bench) PASS',
+		'(rwlock-bench) end');
+pass;
@@ -0,0 +1,110 @@
+/* Times allocating and freeing batches of 40-byte objects from
+   an object cache and from malloc(), and checks that the cache
+   constructs each object only once, keeps objects aligned and
+   in their constructed state, and colours successive slabs. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+#define OBJ_SIZE 40             /* Object size. */
+#define OBJ_ALIGN 8             /* Object alignment. */
+#define BATCH 500               /* Objects allocated at once. */
+#define ROUND_CNT 200           /* Batches to allocate and free. */
+#define OBJ_MAGIC 0x0b1ec7ed
+
+/* An object whose constructor sets it up. */
+struct obj {
+  unsigned magic;
+  char data[OBJ_SIZE - sizeof (unsigned)];
+};
+
+static void *objs[BATCH];
+static int ctor_cnt;
+
+static void
+obj_ctor (void *p) 
+{
+  struct obj *o = p;
+  o->magic = OBJ_MAGIC;
+  ctor_cnt++;
+}
+
+void
+test_slab_bench (void) 
+{
+  struct kmem_cache *cache;
+  uint64_t start, slab_cycles, malloc_cycles;
+  bool coloured = false;
+  int round, i;
+
+  cache = kmem_cache_create ("slab-bench", sizeof (struct obj), OBJ_ALIGN,
+                             obj_ctor);
+  if (cache == NULL)
+    fail ("kmem_cache_create failed");
+
+  start = rdtsc ();
+  for (round = 0; round < ROUND_CNT; round++) 
+    {
+      for (i = 0; i < BATCH; i++) 
+        {
+          struct obj *o = kmem_cache_alloc (cache);
+          if (o == NULL)
+            fail ("kmem_cache_alloc failed");
+          if (o->magic != OBJ_MAGIC)
+            fail ("object %d not in constructed state", i);
+          objs[i] = o;
+        }
+      for (i = 0; i < BATCH; i++)
+        kmem_cache_free (cache, objs[i]);
+    }
+  slab_cycles = rdtsc () - start;
+
+  start = rdtsc ();
+  for (round = 0; round < ROUND_CNT; round++) 
+    {
+      for (i = 0; i < BATCH; i++) 
+        {
+          struct obj *o = malloc (sizeof *o);
+          if (o == NULL)
+            fail ("malloc failed");
+          o->magic = OBJ_MAGIC;
+          objs[i] = o;
+        }
+      for (i = 0; i < BATCH; i++)
+        free (objs[i]);
+    }
+  malloc_cycles = rdtsc () - start;
+
+  /* Check alignment and colouring on one live batch. */
+  for (i = 0; i < BATCH; i++) 
+    {
+      objs[i] = kmem_cache_alloc (cache);
+      if ((uintptr_t) objs[i] % OBJ_ALIGN != 0)
+        fail ("object %p misaligned", objs[i]);
+      if (pg_ofs (objs[i]) % cache->slot_size
+          != pg_ofs (objs[0]) % cache->slot_size)
+        coloured = true;
+    }
+  slab_print_stats ();
+  for (i = 0; i < BATCH; i++)
+    kmem_cache_free (cache, objs[i]);
+
+  if (ctor_cnt >= ROUND_CNT * BATCH)
+    fail ("constructor ran %d times for %d allocations",
+          ctor_cnt, ROUND_CNT * BATCH);
+  if (cache->colour_max > 0 && !coloured)
+    fail ("slabs not coloured");
+
+  msg ("Constructor ran %d times for %d allocations.",
+       ctor_cnt, (ROUND_CNT + 1) * BATCH);
+  msg ("Object cache: %llu cycles per allocate/free pair.",
+       (unsigned long long) (slab_cycles / (ROUND_CNT * BATCH)));
+  msg ("malloc: %llu cycles per allocate/free pair.",
+       (unsigned long long) (malloc_cycles / (ROUND_CNT * BATCH)));
+  pass ();
+}
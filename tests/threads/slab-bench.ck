@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(slab-bench) begin',
+		qr/\(slab-bench\) Constructor ran \d+ times for 100500 allocations\./,
+		qr/\(slab-bench\) Object cache: \d+ cycles per allocate\/free pair\./,
+		qr/\(slab-bench\) malloc: \d+ cycles per allocate\/free pair\./,
+		'(slab-bench) PASS',
+		'(slab-bench) end');
+pass;
@@ -0,0 +1,63 @@
+/* Bounces control between two threads through a pair of
+   semaphores, 1,000,000 times, the same way sema_self_test()
+   does, and reports the average TSC cycles per round trip and
+   per thread switch.  Each round trip is two switches, plus a
+   sema_up() and sema_down() on each side. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define ROUND_TRIPS 1000000     /* Number of round trips. */
+
+static struct semaphore ping, pong;
+static thread_func ponger;
+
+void
+test_switch_pingpong (void) 
+{
+  uint64_t start, cycles;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&ping, 0);
+  sema_init (&pong, 0);
+  thread_create ("ponger", PRI_DEFAULT, ponger, NULL);
+
+  /* Let the ponger run up to its first sema_down(), so that the
+     timed loop only ever switches between two running threads. */
+  sema_up (&ping);
+  sema_down (&pong);
+
+  msg ("Bouncing between 2 threads %d times.", ROUND_TRIPS);
+  start = rdtsc ();
+  for (i = 0; i < ROUND_TRIPS; i++) 
+    {
+      sema_up (&ping);
+      sema_down (&pong);
+    }
+  cycles = rdtsc () - start;
+
+  msg ("%llu cycles per round trip, %llu cycles per switch.",
+       (unsigned long long) (cycles / ROUND_TRIPS),
+       (unsigned long long) (cycles / ROUND_TRIPS / 2));
+  pass ();
+}
+
+/* Answers every ping with a pong. */
+static void
+ponger (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i <= ROUND_TRIPS; i++) 
+    {
+      sema_down (&ping);
+      sema_up (&pong);
+    }
+}
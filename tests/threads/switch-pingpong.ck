@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(switch-pingpong) begin',
+		'(switch-pingpong) Bouncing between 2 threads 1000000 times.',
+		qr/\(switch-pingpong\) \d+ cycles per round trip, \d+ cycles per switch\./,
+		'(switch-pingpong) PASS',
+		'(switch-pingpong) end');
+pass;
@@ -17,6 +17,8 @@ static const struct test tests[] =
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-stagger", test_alarm_stagger},
+    {"alarm-defer", test_alarm_defer},
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
     {"priority-donate-multiple", test_priority_donate_multiple},
@@ -25,9 +27,28 @@ static const struct test tests[] =
     {"priority-donate-sema", test_priority_donate_sema},
     {"priority-donate-lower", test_priority_donate_lower},
     {"priority-donate-chain", test_priority_donate_chain},
+    {"priority-donate-stress", test_priority_donate_stress},
+    {"priority-donate-rwlock", test_priority_donate_rwlock},
+    {"priority-waitq", test_priority_waitq},
     {"priority-fifo", test_priority_fifo},
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
+    {"switch-pingpong", test_switch_pingpong},
+    {"thread-storm", test_thread_storm},
+    {"rwlock-bench", test_rwlock_bench},
+    {"intr-profile", test_intr_profile},
+    {"edf-admit", test_edf_admit},
+    {"edf-miss", test_edf_miss},
+    {"edf-bench", test_edf_bench},
+    {"lock-bench", test_lock_bench},
+    {"palloc-zero", test_palloc_zero},
+    {"handoff-pingpong", test_handoff_pingpong},
+    {"ceiling-bench", test_ceiling_bench},
+    {"palloc-bench", test_palloc_bench},
+    {"slab-bench", test_slab_bench},
+    {"malloc-trace", test_malloc_trace},
+    {"alloc-profile", test_alloc_profile},
+    {"tlb-bench", test_tlb_bench},
 #ifdef DO_TEST_CONDVAR
     {"priority-condvar", test_priority_condvar},
 #endif
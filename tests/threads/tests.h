@@ -11,6 +11,8 @@ extern test_func test_alarm_simultaneous;
 extern test_func test_alarm_priority;
 extern test_func test_alarm_zero;
 extern test_func test_alarm_negative;
+extern test_func test_alarm_stagger;
+extern test_func test_alarm_defer;
 extern test_func test_priority_change;
 extern test_func test_priority_donate_one;
 extern test_func test_priority_donate_multiple;
@@ -19,9 +21,28 @@ extern test_func test_priority_donate_sema;
 extern test_func test_priority_donate_nest;
 extern test_func test_priority_donate_lower;
 extern test_func test_priority_donate_chain;
+extern test_func test_priority_donate_stress;
+extern test_func test_priority_donate_rwlock;
+extern test_func test_priority_waitq;
 extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
+extern test_func test_switch_pingpong;
+extern test_func test_thread_storm;
+extern test_func test_rwlock_bench;
+extern test_func test_intr_profile;
+extern test_func test_edf_admit;
+extern test_func test_edf_miss;
+extern test_func test_edf_bench;
+extern test_func test_lock_bench;
+extern test_func test_palloc_zero;
+extern test_func test_handoff_pingpong;
+extern test_func test_ceiling_bench;
+extern test_func test_palloc_bench;
+extern test_func test_slab_bench;
+extern test_func test_malloc_trace;
+extern test_func test_alloc_profile;
+extern test_func test_tlb_bench;
 extern test_func test_priority_condvar;
 extern test_func test_mlfqs_load_1;
 extern test_func test_mlfqs_load_60;
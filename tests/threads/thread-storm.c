@@ -0,0 +1,46 @@
+/* Creates 10,000 short-lived threads, one after another, and
+   reports the average TSC cycles for each create and exit.  Each
+   thread has a higher priority than the test, so it runs and
+   exits before thread_create() returns, and its page is ready to
+   be reused by the next one. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define THREAD_CNT 10000        /* Number of threads to create. */
+
+static thread_func exiter;
+static int exited;
+
+void
+test_thread_storm (void) 
+{
+  uint64_t start, cycles;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("Creating and exiting %d threads.", THREAD_CNT);
+  start = rdtsc ();
+  for (i = 0; i < THREAD_CNT; i++) 
+    if (thread_create ("exiter", PRI_DEFAULT + 1, exiter, NULL) == TID_ERROR)
+      fail ("thread_create failed for thread %d", i);
+  cycles = rdtsc () - start;
+
+  if (exited != THREAD_CNT)
+    fail ("only %d of %d threads ran", exited, THREAD_CNT);
+  msg ("%llu cycles per thread create and exit.",
+       (unsigned long long) (cycles / THREAD_CNT));
+  pass ();
+}
+
+/* Exits as soon as it runs. */
+static void
+exiter (void *aux UNUSED) 
+{
+  exited++;
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(thread-storm) begin',
+		'(thread-storm) Creating and exiting 10000 threads.',
+		qr/\(thread-storm\) \d+ cycles per thread create and exit\./,
+		'(thread-storm) PASS',
+		'(thread-storm) end');
+pass;
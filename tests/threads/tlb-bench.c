@@ -0,0 +1,81 @@
+/* Checks that the kernel's mapping of physical memory uses 2 MB
+   pages where it can while keeping the kernel text read-only,
+   then times reads and writes spread one per page over 16 MB of
+   kernel memory, which is more pages than the TLB holds as 4 kB
+   pages but only 8 as 2 MB pages.  Run with 128 MB of memory, so
+   that the kernel pool has room for the buffers. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+#define BUF_CNT 4               /* Buffers. */
+#define BUF_PAGES 1024          /* Pages per buffer, the most palloc gives. */
+#define PAGE_CNT (BUF_CNT * BUF_PAGES)
+#define STRIDE 617              /* Odd, so it visits every page. */
+#define ROUND_CNT 50            /* Passes over the buffers. */
+
+void
+test_tlb_bench (void) 
+{
+  uint8_t *bufs[BUF_CNT];
+  uint64_t *pte, start, cycles;
+  size_t large = 0;
+  size_t i, j;
+  int round;
+
+  /* Kernel text is mapped with read-only 4 kB pages. */
+  pte = pml4e_walk (base_pml4, (uint64_t) test_tlb_bench, 0);
+  if (pte == NULL || !(*pte & PTE_P))
+    fail ("kernel text not mapped with a page table entry");
+  if (*pte & PTE_W)
+    fail ("kernel text is writable");
+
+  for (i = 0; i < BUF_CNT; i++) 
+    {
+      bufs[i] = palloc_get_multiple (0, BUF_PAGES);
+      if (bufs[i] == NULL)
+        fail ("palloc_get_multiple failed");
+    }
+
+  /* Each buffer holds at least one whole aligned 2 MB region, and
+     none of them can be the one holding the kernel text. */
+  for (i = 0; i < BUF_CNT; i++)
+    for (j = 0; j < BUF_PAGES; j++) 
+      {
+        uint64_t va = (uint64_t) (bufs[i] + j * PGSIZE);
+        uint64_t *pde = pml4e_walk_pde (base_pml4, va, 0);
+
+        if (pde != NULL && (*pde & PTE_PS)) 
+          {
+            if (pml4e_walk (base_pml4, va, 0) != NULL)
+              fail ("page table entry found under a 2 MB page");
+            large++;
+          }
+      }
+  if (large < BUF_CNT * (LARGE_PGSIZE / PGSIZE))
+    fail ("only %zu of %d buffer pages mapped by 2 MB pages",
+          large, PAGE_CNT);
+  msg ("%zu of %d buffer pages mapped by 2 MB pages.", large, PAGE_CNT);
+
+  start = rdtsc ();
+  for (round = 0; round < ROUND_CNT; round++)
+    for (i = 0; i < PAGE_CNT; i++) 
+      {
+        size_t page = i * STRIDE % PAGE_CNT;
+        bufs[page / BUF_PAGES][page % BUF_PAGES * PGSIZE + i % 64 * 64]++;
+      }
+  cycles = rdtsc () - start;
+
+  for (i = 0; i < BUF_CNT; i++)
+    palloc_free_multiple (bufs[i], BUF_PAGES);
+
+  msg ("%llu cycles per access.",
+       (unsigned long long) (cycles / (ROUND_CNT * PAGE_CNT)));
+  pass ();
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(tlb-bench) begin',
+		qr/\(tlb-bench\) \d+ of 4096 buffer pages mapped by 2 MB pages\./,
+		qr/\(tlb-bench\) \d+ cycles per access\./,
+		'(tlb-bench) PASS',
+		'(tlb-bench) end');
+pass;
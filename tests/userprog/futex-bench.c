@@ -0,0 +1,73 @@
+/* Times a futex-based mutex against a lock that enters the
+   kernel on every operation.  The mutex is never contended here,
+   so it should never enter the kernel at all.  Also checks that
+   futex_wait() returns at once when the word has changed and
+   rejects a bad address. */
+
+#include <mutex.h>
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ITER_CNT 100000         /* Lock/unlock pairs to time. */
+
+static inline uint64_t
+rdtsc (void) 
+{
+  uint32_t lo, hi;
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+/* A lock that enters the kernel once per acquire and once per
+   release, as one without a user-space fast path must. */
+static void
+syscall_lock (struct mutex *m) 
+{
+  futex_wake (&m->state, 0);
+  mutex_lock (m);
+}
+
+static void
+syscall_unlock (struct mutex *m) 
+{
+  mutex_unlock (m);
+  futex_wake (&m->state, 0);
+}
+
+void
+test_main (void) 
+{
+  struct mutex m = MUTEX_INITIALIZER;
+  struct cond c = COND_INITIALIZER;
+  uint64_t start, fast, slow;
+  int i;
+
+  CHECK (futex_wait (&m.state, 1) == 1,
+         "futex_wait on a changed word returns at once");
+  CHECK (futex_wait ((int *) 0xc0000000, 0) == -1,
+         "futex_wait on an unmapped word fails");
+
+  start = rdtsc ();
+  for (i = 0; i < ITER_CNT; i++) 
+    {
+      mutex_lock (&m);
+      cond_signal (&c, &m);
+      mutex_unlock (&m);
+    }
+  fast = rdtsc () - start;
+
+  start = rdtsc ();
+  for (i = 0; i < ITER_CNT; i++) 
+    {
+      syscall_lock (&m);
+      syscall_unlock (&m);
+    }
+  slow = rdtsc () - start;
+
+  msg ("futex mutex: %llu cycles per lock/unlock",
+       (unsigned long long) (fast / ITER_CNT));
+  msg ("syscall lock: %llu cycles per lock/unlock",
+       (unsigned long long) (slow / ITER_CNT));
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(futex-bench) begin',
+		'(futex-bench) futex_wait on a changed word returns at once',
+		'(futex-bench) futex_wait on an unmapped word fails',
+		qr/\(futex-bench\) futex mutex: \d+ cycles per lock\/unlock/,
+		qr/\(futex-bench\) syscall lock: \d+ cycles per lock\/unlock/,
+		'(futex-bench) end',
+		'futex-bench: exit(0)');
+pass;
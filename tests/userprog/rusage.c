@@ -0,0 +1,42 @@
+/* Checks that getrusage() charges time spent spinning in user
+   mode to user time and time spent in system calls to kernel
+   time, and that it rejects a buffer it cannot write. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SPIN_CNT 10000000       /* Iterations of the user-mode loop. */
+#define CALL_CNT 10000          /* System calls to make. */
+
+void
+test_main (void) 
+{
+  struct rusage before, after;
+  volatile int spin = 0;
+  int i;
+
+  CHECK (getrusage (&before) == 0, "getrusage");
+
+  for (i = 0; i < SPIN_CNT; i++)
+    spin++;
+  CHECK (getrusage (&after) == 0, "getrusage after spinning");
+  CHECK (after.utime_ns > before.utime_ns, "user time increased");
+  msg ("spin: %llu ns user, %llu ns kernel",
+       (unsigned long long) (after.utime_ns - before.utime_ns),
+       (unsigned long long) (after.stime_ns - before.stime_ns));
+
+  before = after;
+  for (i = 0; i < CALL_CNT; i++)
+    getrusage (&after);
+  CHECK (after.stime_ns > before.stime_ns, "kernel time increased");
+  msg ("%llu kernel cycles per system call",
+       (unsigned long long) ((after.stime_cycles - before.stime_cycles)
+                             / CALL_CNT));
+
+  CHECK (getrusage ((struct rusage *) test_main) == -1,
+         "getrusage into read-only code fails");
+  CHECK (getrusage ((struct rusage *) 0x8004000000) == -1,
+         "getrusage into kernel memory fails");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_patterns ('(rusage) begin',
+		'(rusage) getrusage',
+		'(rusage) getrusage after spinning',
+		'(rusage) user time increased',
+		qr/\(rusage\) spin: \d+ ns user, \d+ ns kernel/,
+		'(rusage) kernel time increased',
+		qr/\(rusage\) \d+ kernel cycles per system call/,
+		'(rusage) getrusage into read-only code fails',
+		'(rusage) getrusage into kernel memory fails',
+		'(rusage) end',
+		'rusage: exit(0)');
+pass;
@@ -0,0 +1,272 @@
+#include "threads/allocprof.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "threads/palloc.h"
+#include "threads/spinlock.h"
+#include "threads/vaddr.h"
+
+/* Allocation profiler, enabled by the -allocprof option.  See
+   allocprof.h for an overview.
+
+   Live allocations are kept in an open-addressed hash table,
+   keyed by address with linear probing, that takes LIVE_PAGES
+   pages from the kernel pool when profiling starts.  Each entry
+   names the call site it is charged to and its size, so that
+   alloc_profile_forget() can take it off that site's totals.
+   Allocations made before profiling started are not in the
+   table, so freeing them changes nothing.  Pages that malloc()
+   gets for its own arenas show up as palloc allocations from
+   malloc.c, apart from the blocks carved out of them.
+
+   The tables are protected by a spin lock rather than a struct
+   lock, so that recording an allocation can never sleep and so
+   cannot change the scheduling of the code being profiled. */
+bool alloc_profile;
+
+#define ALLOC_SITES 256         /* Call sites tracked. */
+#define LIVE_PAGES 64           /* Pages in the live table. */
+#define LIVE_BITS 14            /* Log2 of entries in the live table. */
+#define LIVE_CNT ((size_t) 1 << LIVE_BITS)
+
+/* Allocations made by one call site. */
+struct alloc_site {
+	uint64_t rip;               /* Return address of the call. */
+	enum alloc_kind kind;       /* Allocator called. */
+	uint64_t count;             /* Allocations. */
+	uint64_t bytes;             /* Bytes allocated. */
+	uint64_t live_count;        /* Allocations not yet freed. */
+	uint64_t live_bytes;        /* Bytes not yet freed. */
+	uint64_t peak_bytes;        /* Most live_bytes seen. */
+};
+
+/* A live allocation. */
+struct live_alloc {
+	uintptr_t addr;             /* Address, or 0 if entry unused. */
+	uint32_t site;              /* Index in sites. */
+	uint32_t size;              /* Size in bytes. */
+};
+
+static struct alloc_site sites[ALLOC_SITES];  /* Hashed by rip. */
+static struct live_alloc *live;  /* LIVE_CNT entries, hashed by addr. */
+static size_t live_cnt;          /* Entries in use. */
+static uint64_t allocs_dropped;  /* Allocations lost to a full table. */
+static struct spinlock prof_lock; /* Protects all of the above. */
+
+static size_t live_hash (uintptr_t addr);
+static struct alloc_site *find_site (uintptr_t rip, enum alloc_kind);
+static void live_remove (size_t i);
+
+/* Starts profiling afresh, forgetting anything recorded before.
+   Returns false if the live table could not be allocated. */
+bool
+alloc_profile_start (void) {
+	if (live == NULL) {
+		spinlock_init (&prof_lock, "allocprof");
+		live = palloc_get_multiple (0, LIVE_PAGES);
+		if (live == NULL) {
+			printf ("Allocation profiler: no memory for live table\n");
+			alloc_profile = false;
+			return false;
+		}
+		ASSERT (LIVE_CNT * sizeof *live <= LIVE_PAGES * PGSIZE);
+	}
+
+	spinlock_acquire (&prof_lock);
+	memset (sites, 0, sizeof sites);
+	memset (live, 0, LIVE_CNT * sizeof *live);
+	live_cnt = 0;
+	allocs_dropped = 0;
+	alloc_profile = true;
+	spinlock_release (&prof_lock);
+	return true;
+}
+
+/* Charges the SIZE-byte allocation at P, from the allocator of
+   the given KIND, to the call that returns to SITE. */
+void
+alloc_profile_record (enum alloc_kind kind, void *p, size_t size,
+		uintptr_t site) {
+	struct alloc_site *s;
+
+	if (live == NULL || p == NULL)
+		return;
+
+	spinlock_acquire (&prof_lock);
+	s = find_site (site, kind);
+	if (s != NULL && live_cnt < LIVE_CNT - 1) {
+		size_t i = live_hash ((uintptr_t) p);
+
+		while (live[i].addr != 0)
+			i = (i + 1) % LIVE_CNT;
+		live[i].addr = (uintptr_t) p;
+		live[i].site = s - sites;
+		live[i].size = size;
+		live_cnt++;
+
+		s->count++;
+		s->bytes += size;
+		s->live_count++;
+		s->live_bytes += size;
+		if (s->live_bytes > s->peak_bytes)
+			s->peak_bytes = s->live_bytes;
+	} else
+		allocs_dropped++;
+	spinlock_release (&prof_lock);
+}
+
+/* Takes the allocation at P off its call site's outstanding
+   totals, if it is being tracked. */
+void
+alloc_profile_forget (void *p) {
+	size_t i;
+
+	if (live == NULL || p == NULL)
+		return;
+
+	spinlock_acquire (&prof_lock);
+	for (i = live_hash ((uintptr_t) p); live[i].addr != 0;
+			i = (i + 1) % LIVE_CNT)
+		if (live[i].addr == (uintptr_t) p) {
+			struct alloc_site *s = &sites[live[i].site];
+
+			s->live_count--;
+			s->live_bytes -= live[i].size;
+			live_remove (i);
+			break;
+		}
+	spinlock_release (&prof_lock);
+}
+
+/* Stores the number of allocations still live, and their total
+   size in bytes, in *CNT and *BYTES. */
+void
+alloc_profile_outstanding (uint64_t *cnt, uint64_t *bytes) {
+	size_t i;
+
+	spinlock_acquire (&prof_lock);
+	*cnt = *bytes = 0;
+	for (i = 0; i < ALLOC_SITES; i++) {
+		*cnt += sites[i].live_count;
+		*bytes += sites[i].live_bytes;
+	}
+	spinlock_release (&prof_lock);
+}
+
+/* qsort() comparison for pointers to struct alloc_site, most
+   outstanding bytes first, then most bytes allocated. */
+static int
+site_compare (const void *a_, const void *b_) {
+	const struct alloc_site *a = *(const struct alloc_site **) a_;
+	const struct alloc_site *b = *(const struct alloc_site **) b_;
+
+	if (a->live_bytes != b->live_bytes)
+		return a->live_bytes < b->live_bytes ? 1 : -1;
+	return a->bytes < b->bytes ? 1 : a->bytes > b->bytes ? -1 : 0;
+}
+
+/* Prints the allocation profile: each call site's allocations,
+   total and outstanding, most outstanding bytes first. */
+void
+alloc_dump_profile (void) {
+	static struct alloc_site copy[ALLOC_SITES];
+	static struct alloc_site *sorted[ALLOC_SITES];
+	uint64_t live_count = 0, live_bytes = 0, dropped;
+	size_t cnt = 0;
+	size_t i;
+
+	if (live == NULL)
+		return;
+
+	/* Print from a copy, so that the lock need not be held. */
+	spinlock_acquire (&prof_lock);
+	memcpy (copy, sites, sizeof sites);
+	dropped = allocs_dropped;
+	spinlock_release (&prof_lock);
+
+	for (i = 0; i < ALLOC_SITES; i++)
+		if (copy[i].rip != 0) {
+			sorted[cnt++] = &copy[i];
+			live_count += copy[i].live_count;
+			live_bytes += copy[i].live_bytes;
+		}
+	qsort (sorted, cnt, sizeof *sorted, site_compare);
+
+	printf ("Allocations at %zu sites, %"PRIu64" outstanding "
+			"(%"PRIu64" bytes)", cnt, live_count, live_bytes);
+	if (dropped != 0)
+		printf (", %"PRIu64" more allocations dropped", dropped);
+	printf (":\n  %-18s %-6s %10s %14s %8s %12s %12s\n",
+			"site", "kind", "allocs", "bytes", "live", "live bytes",
+			"peak bytes");
+	for (i = 0; i < cnt; i++) {
+		const struct alloc_site *s = sorted[i];
+
+		printf ("  %#018"PRIx64" %-6s %10"PRIu64" %14"PRIu64" %8"PRIu64
+				" %12"PRIu64" %12"PRIu64"\n", s->rip,
+				s->kind == ALLOC_PALLOC ? "palloc" : "malloc",
+				s->count, s->bytes, s->live_count, s->live_bytes,
+				s->peak_bytes);
+	}
+
+	/* Same form as debug_backtrace(), for the `backtrace' tool. */
+	printf ("Sites:");
+	for (i = 0; i < cnt; i++)
+		printf (" %#"PRIx64, sorted[i]->rip);
+	printf (".\n");
+}
+
+/* Returns the live table slot where the search for ADDR starts. */
+static size_t
+live_hash (uintptr_t addr) {
+	return (addr * 0x9e3779b97f4a7c15ULL) >> (64 - LIVE_BITS);
+}
+
+/* Returns the entry for the call site RIP of the given KIND,
+   adding it if need be, or a null pointer if the table is full.
+   prof_lock must be held. */
+static struct alloc_site *
+find_site (uintptr_t rip, enum alloc_kind kind) {
+	size_t i = (rip * 0x9e3779b97f4a7c15ULL) >> 32;
+	size_t probe;
+
+	for (probe = 0; probe < ALLOC_SITES; probe++) {
+		struct alloc_site *s = &sites[(i + probe) % ALLOC_SITES];
+
+		if (s->rip == 0) {
+			s->rip = rip;
+			s->kind = kind;
+		}
+		if (s->rip == rip)
+			return s;
+	}
+	return NULL;
+}
+
+/* Empties live table slot I, moving later entries of its probe
+   sequence back so that every entry stays reachable from its
+   hash slot.  prof_lock must be held. */
+static void
+live_remove (size_t i) {
+	size_t j = i;
+
+	for (;;) {
+		size_t home;
+
+		j = (j + 1) % LIVE_CNT;
+		if (live[j].addr == 0)
+			break;
+
+		/* Entry J may fill hole I unless its home slot lies
+		   cyclically in (I, J]. */
+		home = live_hash (live[j].addr);
+		if (i <= j ? i < home && home <= j : i < home || home <= j)
+			continue;
+		live[i] = live[j];
+		i = j;
+	}
+	live[i].addr = 0;
+	live_cnt--;
+}
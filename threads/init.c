@@ -1,6 +1,7 @@
 #include "threads/init.h"
 #include <console.h>
 #include <debug.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <random.h>
 #include <stddef.h>
@@ -13,14 +14,17 @@
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
+#include "threads/allocprof.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
 #include "threads/mmu.h"
 #include "threads/palloc.h"
+#include "threads/slab.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -29,6 +33,7 @@
 #include "userprog/tss.h"
 #endif
 #include "tests/threads/tests.h"
+#include "intrinsic.h"
 #ifdef VM
 #include "vm/vm.h"
 #endif
@@ -38,6 +43,9 @@
 #include "filesys/fsutil.h"
 #endif
 
+/* CR4 bit that enables global pages. */
+#define CR4_PGE 0x80
+
 /* Page-map-level-4 with kernel mappings only. */
 uint64_t *base_pml4;
 
@@ -53,6 +61,7 @@ bool thread_tests;
 
 static void bss_init (void);
 static void paging_init (uint64_t mem_end);
+static size_t count_table_pages (const uint64_t *table, int level);
 
 static char **read_command_line (void);
 static char **parse_options (char **argv);
@@ -85,6 +94,9 @@ main (void) {
 	/* Initialize memory system. */
 	mem_end = palloc_init ();
 	malloc_init ();
+	slab_init ();
+	if (alloc_profile)
+		alloc_profile_start ();
 	paging_init (mem_end);
 
 #ifdef USERPROG
@@ -103,6 +115,7 @@ main (void) {
 #endif
 	/* Start thread scheduler and enable interrupts. */
 	thread_start ();
+	workqueue_init ();
 	serial_init_queue ();
 	timer_calibrate ();
 
@@ -142,29 +155,78 @@ bss_init (void) {
 
 /* Populates the page table with the kernel virtual mapping,
  * and then sets up the CPU to use the new page directory.
- * Points base_pml4 to the pml4 it creates. */
+ * Points base_pml4 to the pml4 it creates.
+ *
+ * Memory is mapped with 2 MB pages wherever a whole aligned 2 MB
+ * of it can be, which takes one page directory per 1 GB instead of
+ * one page table per 2 MB, and one TLB entry per 2 MB.  The 2 MB
+ * around the kernel text, which must stay read-only, and any tail
+ * past the last 2 MB boundary are mapped with 4 kB pages.  (1 GB
+ * pages would need KERN_BASE to be 1 GB aligned, which it is not.)
+ * All of it is global, so that switching between processes'
+ * page tables keeps it in the TLB. */
 static void
 paging_init (uint64_t mem_end) {
+	extern char start, _end_kernel_text;
+	uint64_t text_start = vtop (&start);
+	uint64_t text_end = vtop (&_end_kernel_text);
+	size_t large_cnt = 0, small_cnt = 0;
+	uint64_t begin = rdtsc ();
 	uint64_t *pml4, *pte;
+	uint64_t pa;
 	int perm;
 	pml4 = base_pml4 = palloc_get_page (PAL_ASSERT | PAL_ZERO);
 
-	extern char start, _end_kernel_text;
 	// Maps physical address [0 ~ mem_end] to
 	//   [LOADER_KERN_BASE ~ LOADER_KERN_BASE + mem_end].
-	for (uint64_t pa = 0; pa < mem_end; pa += PGSIZE) {
-		uint64_t va = (uint64_t) ptov(pa);
-
-		perm = PTE_P | PTE_W;
+	for (pa = 0; pa < mem_end; ) {
+		uint64_t va = (uint64_t) ptov (pa);
+		uint64_t large_end = pa + LARGE_PGSIZE;
+
+		if (pa % LARGE_PGSIZE == 0 && large_end <= mem_end
+				&& (large_end <= text_start || pa >= text_end)) {
+			pte = pml4e_walk_pde (pml4, va, 1);
+			if (pte == NULL)
+				PANIC ("paging_init: out of pages");
+			*pte = pa | PTE_P | PTE_W | PTE_PS | PTE_G;
+			large_cnt++;
+			pa = large_end;
+			continue;
+		}
+
+		perm = PTE_P | PTE_W | PTE_G;
 		if ((uint64_t) &start <= va && va < (uint64_t) &_end_kernel_text)
 			perm &= ~PTE_W;
 
 		if ((pte = pml4e_walk (pml4, va, 1)) != NULL)
 			*pte = pa | perm;
+		small_cnt++;
+		pa += PGSIZE;
 	}
 
-	// reload cr3
+	// reload cr3, then turn on global pages.  Changing CR4.PGE
+	// flushes the whole TLB, including the boot page tables' low
+	// identity mapping, which must not outlive them.
 	pml4_activate(0);
+	lcr4 (rcr4 () | CR4_PGE);
+
+	printf ("Direct map: %zu 2 MB pages, %zu 4 kB pages, %zu page-table "
+			"pages, %"PRIu64" cycles\n", large_cnt, small_cnt,
+			count_table_pages (pml4, 3), rdtsc () - begin);
+}
+
+/* Returns the number of pages in the page table TABLE, which is
+   at LEVEL levels above the page tables proper, and under it. */
+static size_t
+count_table_pages (const uint64_t *table, int level) {
+	size_t cnt = 1;
+	size_t i;
+
+	if (level > 0)
+		for (i = 0; i < PGSIZE / sizeof *table; i++)
+			if ((table[i] & PTE_P) && !(table[i] & PTE_PS))
+				cnt += count_table_pages (ptov (PTE_ADDR (table[i])), level - 1);
+	return cnt;
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -221,6 +283,14 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-tickless"))
+			timer_tickless = true;
+		else if (!strcmp (name, "-donate-depth"))
+			donate_depth = atoi (value);
+		else if (!strcmp (name, "-intrprof"))
+			intr_profile = true;
+		else if (!strcmp (name, "-allocprof"))
+			alloc_profile = true;
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
@@ -252,6 +322,27 @@ run_task (char **argv) {
 	printf ("Execution of '%s' complete.\n", task);
 }
 
+/* Prints scheduler accounting and the context-switch trace. */
+static void
+run_schedstat (char **argv UNUSED) {
+	thread_dump_sched ();
+}
+
+/* Prints the interrupts-off profile. */
+static void
+run_intrprof (char **argv UNUSED) {
+	intr_dump_profile ();
+}
+
+/* Prints memory use by pool and size class, and the allocation
+   profile. */
+static void
+run_allocprof (char **argv UNUSED) {
+	palloc_print_stats ();
+	malloc_print_stats ();
+	alloc_dump_profile ();
+}
+
 /* Executes all of the actions specified in ARGV[]
    up to the null pointer sentinel. */
 static void
@@ -266,6 +357,9 @@ run_actions (char **argv) {
 	/* Table of supported actions. */
 	static const struct action actions[] = {
 		{"run", 2, run_task},
+		{"schedstat", 1, run_schedstat},
+		{"intrprof", 1, run_intrprof},
+		{"allocprof", 1, run_allocprof},
 #ifdef FILESYS
 		{"ls", 1, fsutil_ls},
 		{"cat", 2, fsutil_cat},
@@ -312,6 +406,10 @@ usage (void) {
 #else
 			"  run TEST           Run TEST.\n"
 #endif
+			"  schedstat          Dump scheduler statistics and switch trace.\n"
+			"  intrprof           Dump the interrupts-off profile (see -intrprof).\n"
+			"  allocprof          Dump memory use and the allocation profile\n"
+			"                     (see -allocprof).\n"
 #ifdef FILESYS
 			"  ls                 List files in the root directory.\n"
 			"  cat FILE           Print FILE to the console.\n"
@@ -326,6 +424,10 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -tickless          Use one-shot timer interrupts, none when idle.\n"
+			"  -donate-depth=N    Pass priority donations through at most N locks.\n"
+			"  -intrprof          Profile interrupts-off time by call site.\n"
+			"  -allocprof         Track live allocations by call site.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
@@ -354,6 +456,13 @@ static void
 print_stats (void) {
 	timer_print_stats ();
 	thread_print_stats ();
+	intr_print_stats ();
+	workqueue_print_stats ();
+	palloc_print_stats ();
+	malloc_print_stats ();
+	slab_print_stats ();
+	if (alloc_profile)
+		alloc_dump_profile ();
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
@@ -3,6 +3,8 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "threads/flags.h"
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
@@ -103,6 +105,47 @@ static const char *intr_names[INTR_CNT];
 static bool in_external_intr;   /* Are we processing an external interrupt? */
 static bool yield_on_return;    /* Should we yield on interrupt return? */
 
+/* Most TSC cycles spent in an external interrupt handler, and the
+   vector it was for. */
+static uint64_t ext_max_cycles;
+static uint8_t ext_max_vec;
+
+/* Interrupts-off profiler, enabled by the -intrprof option.
+
+   A window opens when intr_disable() or intr_set_level() turns
+   interrupts off while they were on, and is charged to that
+   call's return address.  It closes when intr_enable() turns
+   them back on, or when an external interrupt handler returns
+   into a thread that another thread switched to with interrupts
+   off.  A window that ends in some other way, such as the iret
+   that starts a new thread, is discarded when the next one
+   opens. */
+bool intr_profile;
+
+#define PROF_SITES 128          /* Call sites tracked. */
+#define PROF_BUCKETS 40         /* Histogram buckets, log2 cycles. */
+
+/* Interrupts-off windows opened by one call site. */
+struct intr_site {
+	uint64_t rip;               /* Return address of the call. */
+	uint64_t count;             /* Windows. */
+	uint64_t cycles;            /* Total TSC cycles. */
+	uint64_t max;               /* Longest window. */
+	uint32_t hist[PROF_BUCKETS];  /* Windows by log2 cycles. */
+};
+
+static struct intr_site sites[PROF_SITES];  /* Hashed by rip. */
+static uint64_t sites_dropped;  /* Windows lost to a full table. */
+static uintptr_t window_site;   /* Site of open window, or 0. */
+static uint64_t window_start;   /* TSC when it opened. */
+
+/* Invocations of and TSC cycles spent in each vector's handler. */
+static uint64_t vec_count[INTR_CNT];
+static uint64_t vec_cycles[INTR_CNT];
+
+static enum intr_level disable (uintptr_t site);
+static void window_close (void);
+
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
 static void pic_end_of_interrupt (int irq);
@@ -128,7 +171,8 @@ intr_get_level (void) {
    returns the previous interrupt status. */
 enum intr_level
 intr_set_level (enum intr_level level) {
-	return level == INTR_ON ? intr_enable () : intr_disable ();
+	return level == INTR_ON ? intr_enable ()
+		: disable ((uintptr_t) __builtin_return_address (0));
 }
 
 /* Enables interrupts and returns the previous interrupt status. */
@@ -141,6 +185,8 @@ intr_enable (void) {
 
 	   See [IA32-v2b] "STI" and [IA32-v3a] 5.8.1 "Masking Maskable
 	   Hardware Interrupts". */
+	if (old_level == INTR_OFF && window_site != 0)
+		window_close ();
 	asm volatile ("sti");
 
 	return old_level;
@@ -149,6 +195,21 @@ intr_enable (void) {
 /* Disables interrupts and returns the previous interrupt status. */
 enum intr_level
 intr_disable (void) {
+	return disable ((uintptr_t) __builtin_return_address (0));
+}
+
+/* Like intr_disable(), but the interrupts-off window is charged
+   to SITE instead of the caller.  For wrappers such as
+   spinlock_acquire(), which pass their own return address. */
+enum intr_level
+intr_disable_at (uintptr_t site) {
+	return disable (site);
+}
+
+/* Disables interrupts on behalf of the call that returns to SITE
+   and returns the previous interrupt status. */
+static enum intr_level
+disable (uintptr_t site) {
 	enum intr_level old_level = intr_get_level ();
 
 	/* Disable interrupts by clearing the interrupt flag.
@@ -156,9 +217,44 @@ intr_disable (void) {
 	   Hardware Interrupts". */
 	asm volatile ("cli" : : : "memory");
 
+	if (intr_profile && old_level == INTR_ON) {
+		window_site = site;
+		window_start = rdtsc ();
+	}
 	return old_level;
 }
 
+/* Charges the open interrupts-off window to its call site.
+   Interrupts must be off. */
+static void
+window_close (void) {
+	uint64_t cycles = rdtsc () - window_start;
+	uintptr_t rip = window_site;
+	size_t i, probe;
+	int bucket;
+
+	window_site = 0;
+	bucket = cycles > 0 ? (int) bsrq (cycles) : 0;
+	if (bucket >= PROF_BUCKETS)
+		bucket = PROF_BUCKETS - 1;
+	i = (rip * 0x9e3779b97f4a7c15ULL) >> 32;
+	for (probe = 0; probe < PROF_SITES; probe++) {
+		struct intr_site *s = &sites[(i + probe) % PROF_SITES];
+
+		if (s->rip == 0)
+			s->rip = rip;
+		if (s->rip == rip) {
+			s->count++;
+			s->cycles += cycles;
+			if (cycles > s->max)
+				s->max = cycles;
+			s->hist[bucket]++;
+			return;
+		}
+	}
+	sites_dropped++;
+}
+
 /* Initializes the interrupt system. */
 void
 intr_init (void) {
@@ -331,8 +427,12 @@ pic_end_of_interrupt (int irq) {
 void
 intr_handler (struct intr_frame *frame) {
 	bool external;
+	bool from_user = (frame->cs & 3) == 3;
 	intr_handler_func *handler;
 
+	if (from_user)
+		thread_enter_kernel ();
+
 	/* External interrupts are special.
 	   We only handle one at a time (so interrupts must be off)
 	   and they need to be acknowledged on the PIC (see below).
@@ -344,13 +444,28 @@ intr_handler (struct intr_frame *frame) {
 
 		in_external_intr = true;
 		yield_on_return = false;
+
+		/* Interrupts were on, so any open window is stale. */
+		window_site = 0;
 	}
 
 	/* Invoke the interrupt's handler. */
 	handler = intr_handlers[frame->vec_no];
-	if (handler != NULL)
+	if (handler != NULL) {
+		uint64_t start = rdtsc ();
+		uint64_t cycles;
+
 		handler (frame);
-	else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f) {
+		cycles = rdtsc () - start;
+		if (external && cycles > ext_max_cycles) {
+			ext_max_cycles = cycles;
+			ext_max_vec = frame->vec_no;
+		}
+		if (intr_profile) {
+			vec_count[frame->vec_no]++;
+			vec_cycles[frame->vec_no] += cycles;
+		}
+	} else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f) {
 		/* There is no handler, but this interrupt can trigger
 		   spuriously due to a hardware fault or hardware race
 		   condition.  Ignore it. */
@@ -369,9 +484,18 @@ intr_handler (struct intr_frame *frame) {
 		in_external_intr = false;
 		pic_end_of_interrupt (frame->vec_no);
 
-		if (yield_on_return)
-			thread_yield ();
+		if (yield_on_return) {
+			thread_preempt ();
+
+			/* We are back in the preempted thread, about to
+			   return to it with iret. */
+			if (window_site != 0)
+				window_close ();
+		}
 	}
+
+	if (from_user)
+		thread_leave_kernel ();
 }
 
 /* Dumps interrupt frame F to the console, for debugging. */
@@ -403,3 +527,114 @@ const char *
 intr_name (uint8_t vec) {
 	return intr_names[vec];
 }
+
+/* Returns the most TSC cycles any external interrupt handler has
+   run for, with interrupts off, since the last call to
+   intr_clear_max_cycles(). */
+uint64_t
+intr_max_cycles (void) {
+	return ext_max_cycles;
+}
+
+/* Restarts the measurement behind intr_max_cycles(). */
+void
+intr_clear_max_cycles (void) {
+	enum intr_level old_level = intr_disable ();
+	ext_max_cycles = 0;
+	intr_set_level (old_level);
+}
+
+/* Prints interrupt statistics. */
+void
+intr_print_stats (void) {
+	printf ("Interrupts: longest handler %"PRIu64" cycles (%s)\n",
+			ext_max_cycles, intr_name (ext_max_vec));
+}
+
+/* Returns the longest interrupts-off window the profiler has
+   seen since the last call to intr_profile_reset(). */
+uint64_t
+intr_off_max_cycles (void) {
+	uint64_t max = 0;
+	size_t i;
+
+	for (i = 0; i < PROF_SITES; i++)
+		if (sites[i].max > max)
+			max = sites[i].max;
+	return max;
+}
+
+/* Forgets everything the profiler has recorded. */
+void
+intr_profile_reset (void) {
+	enum intr_level old_level = intr_disable ();
+
+	memset (sites, 0, sizeof sites);
+	memset (vec_count, 0, sizeof vec_count);
+	memset (vec_cycles, 0, sizeof vec_cycles);
+	sites_dropped = 0;
+	window_site = 0;
+	intr_set_level (old_level);
+}
+
+/* qsort() comparison for pointers to struct intr_site, longest
+   window first. */
+static int
+site_compare (const void *a_, const void *b_) {
+	const struct intr_site *a = *(const struct intr_site **) a_;
+	const struct intr_site *b = *(const struct intr_site **) b_;
+
+	return a->max < b->max ? 1 : a->max > b->max ? -1 : 0;
+}
+
+/* Prints the interrupts-off profile: each call site's windows,
+   longest first, with a log2 histogram of their lengths, and each
+   vector's handler invocations and cycles. */
+void
+intr_dump_profile (void) {
+	static struct intr_site *sorted[PROF_SITES];
+	bool was_profiling = intr_profile;
+	size_t cnt = 0;
+	size_t i;
+	int b;
+
+	/* Printing disables interrupts too. */
+	intr_profile = false;
+
+	for (i = 0; i < PROF_SITES; i++)
+		if (sites[i].rip != 0)
+			sorted[cnt++] = &sites[i];
+	qsort (sorted, cnt, sizeof *sorted, site_compare);
+
+	printf ("Interrupts-off windows at %zu sites", cnt);
+	if (sites_dropped != 0)
+		printf (", %"PRIu64" more windows dropped", sites_dropped);
+	printf (":\n  %-18s %10s %14s %12s\n",
+			"site", "windows", "total cycles", "max cycles");
+	for (i = 0; i < cnt; i++) {
+		const struct intr_site *s = sorted[i];
+
+		printf ("  %#018"PRIx64" %10"PRIu64" %14"PRIu64" %12"PRIu64"\n",
+				s->rip, s->count, s->cycles, s->max);
+		printf ("   ");
+		for (b = 0; b < PROF_BUCKETS; b++)
+			if (s->hist[b] != 0)
+				printf (" 2^%d:%"PRIu32, b, s->hist[b]);
+		printf ("\n");
+	}
+
+	printf ("Interrupt handlers:\n  %-4s %-36s %10s %14s\n",
+			"vec", "name", "count", "cycles");
+	for (i = 0; i < INTR_CNT; i++)
+		if (vec_count[i] != 0)
+			printf ("  %#04zx %-36s %10"PRIu64" %14"PRIu64"\n",
+					i, intr_names[i], vec_count[i], vec_cycles[i]);
+
+	/* Same form as debug_backtrace(), for the `backtrace' tool. */
+	printf ("Sites:");
+	for (i = 0; i < cnt; i++)
+		printf (" %#"PRIx64, sorted[i]->rip);
+	printf (".\n");
+
+	intr_profile = was_profiling;
+}
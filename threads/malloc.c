@@ -5,30 +5,35 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/allocprof.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "intrinsic.h"
 
 /* A simple implementation of malloc().
 
-   The size of each request, in bytes, is rounded up to a power
-   of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
-   the free list is nonempty, one of its blocks is used to
-   satisfy the request.
-
-   Otherwise, a new page of memory, called an "arena", is
-   obtained from the page allocator (if none is available,
-   malloc() returns a null pointer).  The new arena is divided
-   into blocks, all of which are added to the descriptor's free
-   list.  Then we return one of the new blocks.
-
-   When we free a block, we add it to its descriptor's free list.
-   But if the arena that the block was in now has no in-use
-   blocks, we remove all of the arena's blocks from the free list
-   and give the arena back to the page allocator.
-
-   We can't handle blocks bigger than 2 kB using this scheme,
+   The size of each request, in bytes, is rounded up to the next
+   size class and assigned to the "descriptor" that manages blocks
+   of that size.  The classes are the powers of 2 from 16 to 1024
+   bytes, plus the sizes halfway between them (24, 48, 96, ...)
+   and 1536 bytes, so that no block is much more than a third
+   larger than the request it serves.
+
+   Blocks are carved out of pages, called "arenas", obtained from
+   the page allocator.  Each arena keeps a bitmap of its free
+   blocks, and the descriptor keeps a list of its arenas that have
+   any.  A request takes the first free block of the first arena
+   on that list, and a new arena is allocated only if the list is
+   empty (if none is available, malloc() returns a null pointer).
+
+   When we free a block, we set its bit in its arena's bitmap,
+   putting the arena back on the descriptor's list if it was full.
+   If the arena now has no in-use blocks, we take it off the list
+   and give it back to the page allocator, without having to find
+   its blocks one by one.
+
+   We can't handle blocks bigger than 1.5 kB using this scheme,
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
@@ -38,44 +43,57 @@
 struct desc {
 	size_t block_size;          /* Size of each element in bytes. */
 	size_t blocks_per_arena;    /* Number of blocks in an arena. */
-	struct list free_list;      /* List of free blocks. */
+	struct list arenas;         /* Arenas with free blocks. */
 	struct lock lock;           /* Lock. */
+	size_t in_use;              /* Blocks handed out. */
+	size_t peak;                /* Most blocks handed out at once. */
 };
 
 /* Magic number for detecting arena corruption. */
 #define ARENA_MAGIC 0x9a548eed
 
+/* Most blocks in an arena: PGSIZE divided by the smallest block
+   size, rounded up to whole bitmap words. */
+#define ARENA_BLOCKS_MAX 256
+#define ARENA_MAP_WORDS (ARENA_BLOCKS_MAX / 64)
+
 /* Arena. */
 struct arena {
 	unsigned magic;             /* Always set to ARENA_MAGIC. */
 	struct desc *desc;          /* Owning descriptor, null for big block. */
 	size_t free_cnt;            /* Free blocks; pages in big block. */
+	struct list_elem elem;      /* Element in desc's arenas. */
+	uint64_t free_map[ARENA_MAP_WORDS]; /* 1 bits are free blocks. */
 };
 
-/* Free block. */
-struct block {
-	struct list_elem free_elem; /* Free list element. */
+/* Size classes. */
+static const size_t block_sizes[] = {
+	16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536,
 };
+#define DESC_CNT (sizeof block_sizes / sizeof *block_sizes)
 
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[DESC_CNT]; /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
-static struct arena *block_to_arena (struct block *);
-static struct block *arena_to_block (struct arena *, size_t idx);
+static struct arena *block_to_arena (void *);
+static void *arena_to_block (struct arena *, size_t idx);
+static size_t block_to_idx (struct arena *, void *);
+static void bitmap_set_range (uint64_t *, size_t cnt);
+static void *alloc (size_t size, uintptr_t site);
 
 /* Initializes the malloc() descriptors. */
 void
 malloc_init (void) {
-	size_t block_size;
-
-	for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2) {
-		struct desc *d = &descs[desc_cnt++];
-		ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
-		d->block_size = block_size;
-		d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
-		list_init (&d->free_list);
+	for (desc_cnt = 0; desc_cnt < DESC_CNT; desc_cnt++) {
+		struct desc *d = &descs[desc_cnt];
+		d->block_size = block_sizes[desc_cnt];
+		d->blocks_per_arena =
+			(PGSIZE - sizeof (struct arena)) / d->block_size;
+		ASSERT (d->blocks_per_arena <= ARENA_BLOCKS_MAX);
+		list_init (&d->arenas);
 		lock_init (&d->lock);
+		d->in_use = d->peak = 0;
 	}
 }
 
@@ -83,9 +101,17 @@ malloc_init (void) {
    Returns a null pointer if memory is not available. */
 void *
 malloc (size_t size) {
+	return alloc (size, (uintptr_t) __builtin_return_address (0));
+}
+
+/* Obtains and returns a new block of at least SIZE bytes on
+   behalf of the call that returns to SITE, or a null pointer if
+   memory is not available. */
+static void *
+alloc (size_t size, uintptr_t site) {
 	struct desc *d;
-	struct block *b;
 	struct arena *a;
+	size_t word, idx;
 
 	/* A null pointer satisfies a request for 0 bytes. */
 	if (size == 0)
@@ -109,15 +135,15 @@ malloc (size_t size) {
 		a->magic = ARENA_MAGIC;
 		a->desc = NULL;
 		a->free_cnt = page_cnt;
+		if (alloc_profile)
+			alloc_profile_record (ALLOC_MALLOC, a + 1, size, site);
 		return a + 1;
 	}
 
 	lock_acquire (&d->lock);
 
-	/* If the free list is empty, create a new arena. */
-	if (list_empty (&d->free_list)) {
-		size_t i;
-
+	/* If no arena has a free block, create a new arena. */
+	if (list_empty (&d->arenas)) {
 		/* Allocate a page. */
 		a = palloc_get_page (0);
 		if (a == NULL) {
@@ -125,22 +151,30 @@ malloc (size_t size) {
 			return NULL;
 		}
 
-		/* Initialize arena and add its blocks to the free list. */
+		/* Initialize arena with all of its blocks free. */
 		a->magic = ARENA_MAGIC;
 		a->desc = d;
 		a->free_cnt = d->blocks_per_arena;
-		for (i = 0; i < d->blocks_per_arena; i++) {
-			struct block *b = arena_to_block (a, i);
-			list_push_back (&d->free_list, &b->free_elem);
-		}
+		memset (a->free_map, 0, sizeof a->free_map);
+		bitmap_set_range (a->free_map, d->blocks_per_arena);
+		list_push_front (&d->arenas, &a->elem);
 	}
 
-	/* Get a block from free list and return it. */
-	b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-	a = block_to_arena (b);
-	a->free_cnt--;
+	/* Take the first free block of the first arena. */
+	a = list_entry (list_front (&d->arenas), struct arena, elem);
+	for (word = 0; a->free_map[word] == 0; word++)
+		ASSERT (word < ARENA_MAP_WORDS - 1);
+	idx = word * 64 + bsfq (a->free_map[word]);
+	a->free_map[word] &= ~(1ULL << (idx % 64));
+	if (--a->free_cnt == 0)
+		list_remove (&a->elem);
+	if (++d->in_use > d->peak)
+		d->peak = d->in_use;
 	lock_release (&d->lock);
-	return b;
+
+	if (alloc_profile)
+		alloc_profile_record (ALLOC_MALLOC, arena_to_block (a, idx), size, site);
+	return arena_to_block (a, idx);
 }
 
 /* Allocates and return A times B bytes initialized to zeroes.
@@ -156,7 +190,7 @@ calloc (size_t a, size_t b) {
 		return NULL;
 
 	/* Allocate and zero memory. */
-	p = malloc (size);
+	p = alloc (size, (uintptr_t) __builtin_return_address (0));
 	if (p != NULL)
 		memset (p, 0, size);
 
@@ -166,26 +200,38 @@ calloc (size_t a, size_t b) {
 /* Returns the number of bytes allocated for BLOCK. */
 static size_t
 block_size (void *block) {
-	struct block *b = block;
-	struct arena *a = block_to_arena (b);
+	struct arena *a = block_to_arena (block);
 	struct desc *d = a->desc;
 
 	return d != NULL ? d->block_size : PGSIZE * a->free_cnt - pg_ofs (block);
 }
 
+/* Returns the number of bytes usable in BLOCK, which must have
+   been allocated with malloc(), calloc(), or realloc().  This is
+   at least the size requested. */
+size_t
+malloc_usable_size (void *block) {
+	return block != NULL ? block_size (block) : 0;
+}
+
 /* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
    moving it in the process.
    If successful, returns the new block; on failure, returns a
    null pointer.
    A call with null OLD_BLOCK is equivalent to malloc(NEW_SIZE).
-   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK). */
+   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK).
+   If NEW_SIZE still fits in OLD_BLOCK, returns OLD_BLOCK
+   unchanged. */
 void *
 realloc (void *old_block, size_t new_size) {
 	if (new_size == 0) {
 		free (old_block);
 		return NULL;
+	} else if (old_block != NULL && new_size <= block_size (old_block)) {
+		return old_block;
 	} else {
-		void *new_block = malloc (new_size);
+		void *new_block =
+			alloc (new_size, (uintptr_t) __builtin_return_address (0));
 		if (old_block != NULL && new_block != NULL) {
 			size_t old_size = block_size (old_block);
 			size_t min_size = new_size < old_size ? new_size : old_size;
@@ -201,32 +247,35 @@ realloc (void *old_block, size_t new_size) {
 void
 free (void *p) {
 	if (p != NULL) {
-		struct block *b = p;
-		struct arena *a = block_to_arena (b);
+		struct arena *a = block_to_arena (p);
 		struct desc *d = a->desc;
 
+		if (alloc_profile)
+			alloc_profile_forget (p);
+
 		if (d != NULL) {
 			/* It's a normal block.  We handle it here. */
+			size_t idx = block_to_idx (a, p);
 
 #ifndef NDEBUG
 			/* Clear the block to help detect use-after-free bugs. */
-			memset (b, 0xcc, d->block_size);
+			memset (p, 0xcc, d->block_size);
 #endif
 
 			lock_acquire (&d->lock);
 
-			/* Add block to free list. */
-			list_push_front (&d->free_list, &b->free_elem);
+			/* Mark the block free, and put its arena back on the
+			   descriptor's list if it was full. */
+			ASSERT ((a->free_map[idx / 64] & (1ULL << (idx % 64))) == 0);
+			a->free_map[idx / 64] |= 1ULL << (idx % 64);
+			if (a->free_cnt++ == 0)
+				list_push_front (&d->arenas, &a->elem);
+			d->in_use--;
 
 			/* If the arena is now entirely unused, free it. */
-			if (++a->free_cnt >= d->blocks_per_arena) {
-				size_t i;
-
+			if (a->free_cnt >= d->blocks_per_arena) {
 				ASSERT (a->free_cnt == d->blocks_per_arena);
-				for (i = 0; i < d->blocks_per_arena; i++) {
-					struct block *b = arena_to_block (a, i);
-					list_remove (&b->free_elem);
-				}
+				list_remove (&a->elem);
 				palloc_free_page (a);
 			}
 
@@ -238,10 +287,33 @@ free (void *p) {
 		}
 	}
 }
-
+
+/* Prints the blocks in use and the most ever in use at once for
+   each size class that has been used. */
+void
+malloc_print_stats (void) {
+	size_t i;
+
+	printf ("Malloc: blocks in use/peak by size:");
+	for (i = 0; i < desc_cnt; i++)
+		if (descs[i].peak > 0)
+			printf (" %zu:%zu/%zu", descs[i].block_size, descs[i].in_use,
+					descs[i].peak);
+	printf ("\n");
+}
+
+/* Sets the first CNT bits of MAP. */
+static void
+bitmap_set_range (uint64_t *map, size_t cnt) {
+	for (; cnt >= 64; cnt -= 64)
+		*map++ = UINT64_MAX;
+	if (cnt > 0)
+		*map = (1ULL << cnt) - 1;
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
-block_to_arena (struct block *b) {
+block_to_arena (void *b) {
 	struct arena *a = pg_round_down (b);
 
 	/* Check that the arena is valid. */
@@ -256,13 +328,17 @@ block_to_arena (struct block *b) {
 	return a;
 }
 
-/* Returns the (IDX - 1)'th block within arena A. */
-static struct block *
+/* Returns the IDX'th block within arena A. */
+static void *
 arena_to_block (struct arena *a, size_t idx) {
 	ASSERT (a != NULL);
 	ASSERT (a->magic == ARENA_MAGIC);
 	ASSERT (idx < a->desc->blocks_per_arena);
-	return (struct block *) ((uint8_t *) a
-			+ sizeof *a
-			+ idx * a->desc->block_size);
+	return (uint8_t *) a + sizeof *a + idx * a->desc->block_size;
+}
+
+/* Returns the index of block B within arena A. */
+static size_t
+block_to_idx (struct arena *a, void *b) {
+	return (pg_ofs (b) - sizeof *a) / a->desc->block_size;
 }
@@ -7,7 +7,9 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/allocprof.h"
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -24,13 +26,58 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Within a pool, free pages are managed by a binary buddy
+   allocator.  Free memory is kept as blocks of 2**ORDER pages,
+   aligned to their size relative to the pool base, on one free
+   list per order.  An allocation takes the smallest block that
+   fits, splitting larger ones as needed, and a freed block is
+   merged with its buddy for as long as the buddy is free too, so
+   both take O(log n) time however full the pool is.  A request
+   that is not a power of two gives the unused tail of its block
+   back at once.  The free-list links live in a per-page array
+   beside the bitmap, not in the free pages themselves, because
+   not all of memory is mapped until paging_init() has run.  The
+   bitmap still records which pages are in use, as a check on
+   palloc_free_multiple().
+
+   Each pool also keeps a small stock of free pages that the idle
+   thread has already zeroed, so that single-page PAL_ZERO
+   requests do not have to clear a page on the caller's time.
+   Those pages are marked used in the bitmap; they go back to it
+   if the pool otherwise runs dry.  The stock is only changed with
+   interrupts off, because the idle thread must never block. */
+
+/* Most pre-zeroed pages kept per pool. */
+#define ZEROED_MAX 64
+
+/* Largest block order: 2**MAX_ORDER pages, or 4 MB. */
+#define MAX_ORDER 10
+
+/* Buddy allocator state for one page. */
+struct page_info {
+	struct list_elem elem;          /* Free list element, if free head. */
+	int8_t order;                   /* Order of free block it heads, or -1. */
+};
 
 /* A memory pool. */
 struct pool {
 	struct lock lock;               /* Mutual exclusion. */
 	struct bitmap *used_map;        /* Bitmap of free pages. */
 	uint8_t *base;                  /* Base of pool. */
+
+	struct page_info *pages;        /* Per-page buddy state. */
+	struct list free_lists[MAX_ORDER + 1]; /* Free blocks by order. */
+	size_t free_cnt[MAX_ORDER + 1]; /* Number of blocks on each list. */
+
+	void *zeroed[ZEROED_MAX];       /* Free pages already zeroed. */
+	size_t zeroed_cnt;              /* Number of pages in zeroed. */
+	uint64_t zero_hits;             /* PAL_ZERO pages taken from zeroed. */
+	uint64_t zero_misses;           /* PAL_ZERO pages zeroed on demand. */
+
+	size_t used_cnt;                /* Pages handed out. */
+	size_t used_peak;               /* Most pages handed out at once. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -42,6 +89,15 @@ static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static void init_free_lists (struct pool *);
+static size_t buddy_alloc (struct pool *, size_t page_cnt);
+static void buddy_free (struct pool *, size_t page_idx, size_t page_cnt);
+static void print_pool_stats (const char *name, const struct pool *);
+static void *take_zeroed (struct pool *);
+static bool release_zeroed (struct pool *);
+static bool refill_zeroed (struct pool *);
+static void *get_pages (enum palloc_flags, size_t page_cnt, uintptr_t site);
+static void count_used (struct pool *, size_t page_cnt, bool alloc);
 
 /* multiboot info */
 struct multiboot_info {
@@ -250,6 +306,8 @@ palloc_init (void) {
 	printf ("\text_mem: 0x%llx ~ 0x%llx (Usable: %'llu kB)\n",
 		  ext_mem.start, ext_mem.end, ext_mem.size / 1024);
 	populate_pools (&base_mem, &ext_mem);
+	init_free_lists (&kernel_pool);
+	init_free_lists (&user_pool);
 	return ext_mem.end;
 }
 
@@ -257,31 +315,13 @@ palloc_init (void) {
    If PAL_USER is set, the pages are obtained from the user pool,
    otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
    then the pages are filled with zeros.  If too few pages are
-   available, returns a null pointer, unless PAL_ASSERT is set in
-   FLAGS, in which case the kernel panics. */
+   available, or PAGE_CNT is more than 2**MAX_ORDER, returns a
+   null pointer, unless PAL_ASSERT is set in FLAGS, in which case
+   the kernel panics. */
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
-	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-
-	lock_acquire (&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-	lock_release (&pool->lock);
-	void *pages;
-
-	if (page_idx != BITMAP_ERROR)
-		pages = pool->base + PGSIZE * page_idx;
-	else
-		pages = NULL;
-
-	if (pages) {
-		if (flags & PAL_ZERO)
-			memset (pages, 0, PGSIZE * page_cnt);
-	} else {
-		if (flags & PAL_ASSERT)
-			PANIC ("palloc_get: out of pages");
-	}
-
-	return pages;
+	return get_pages (flags, page_cnt,
+			(uintptr_t) __builtin_return_address (0));
 }
 
 /* Obtains a single free page and returns its kernel virtual
@@ -293,7 +333,7 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
    FLAGS, in which case the kernel panics. */
 void *
 palloc_get_page (enum palloc_flags flags) {
-	return palloc_get_multiple (flags, 1);
+	return get_pages (flags, 1, (uintptr_t) __builtin_return_address (0));
 }
 
 /* Frees the PAGE_CNT pages starting at PAGES. */
@@ -314,12 +354,16 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 		NOT_REACHED ();
 
 	page_idx = pg_no (pages) - pg_no (pool->base);
+	if (alloc_profile)
+		alloc_profile_forget (pages);
+	count_used (pool, page_cnt, false);
 
 #ifndef NDEBUG
 	memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
-	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	lock_acquire (&pool->lock);
+	buddy_free (pool, page_idx, page_cnt);
+	lock_release (&pool->lock);
 }
 
 /* Frees the page at PAGE. */
@@ -328,23 +372,118 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
+/* Called by the idle thread, with interrupts on, to zero one free
+   page for a pool whose stock of zeroed pages is short.  Returns
+   false if every stock is full or no free page could be had. */
+bool
+palloc_zero_idle (void) {
+	return refill_zeroed (&kernel_pool) || refill_zeroed (&user_pool);
+}
+
+/* Prints statistics about free memory and pre-zeroed pages. */
+void
+palloc_print_stats (void) {
+	print_pool_stats ("kernel", &kernel_pool);
+	print_pool_stats ("user", &user_pool);
+	printf ("Palloc: %"PRIu64" zeroed pages preset, %"PRIu64" zeroed "
+			"on demand\n", kernel_pool.zero_hits + user_pool.zero_hits,
+			kernel_pool.zero_misses + user_pool.zero_misses);
+}
+
+/* Stores the number of single-page PAL_ZERO requests that were
+   served from the pre-zeroed stock in *HITS and the number that
+   were not in *MISSES, counting both pools. */
+void
+palloc_zero_stats (uint64_t *hits, uint64_t *misses) {
+	enum intr_level old_level = intr_disable ();
+	*hits = kernel_pool.zero_hits + user_pool.zero_hits;
+	*misses = kernel_pool.zero_misses + user_pool.zero_misses;
+	intr_set_level (old_level);
+}
+
+/* Obtains PAGE_CNT contiguous free pages as described for
+   palloc_get_multiple(), on behalf of the call that returns to
+   SITE. */
+static void *
+get_pages (enum palloc_flags flags, size_t page_cnt, uintptr_t site) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	size_t page_idx;
+	void *pages = NULL;
+
+	if (page_cnt == 1 && flags & PAL_ZERO)
+		pages = take_zeroed (pool);
+
+	if (pages == NULL) {
+		lock_acquire (&pool->lock);
+		page_idx = buddy_alloc (pool, page_cnt);
+		if (page_idx == BITMAP_ERROR && release_zeroed (pool))
+			page_idx = buddy_alloc (pool, page_cnt);
+		lock_release (&pool->lock);
+
+		if (page_idx != BITMAP_ERROR) {
+			pages = pool->base + PGSIZE * page_idx;
+			if (flags & PAL_ZERO)
+				memset (pages, 0, PGSIZE * page_cnt);
+		}
+	}
+
+	if (pages) {
+		count_used (pool, page_cnt, true);
+		if (alloc_profile)
+			alloc_profile_record (ALLOC_PALLOC, pages, PGSIZE * page_cnt, site);
+	} else {
+		if (flags & PAL_ASSERT)
+			PANIC ("palloc_get: out of pages");
+	}
+
+	return pages;
+}
+
+/* Adds PAGE_CNT pages to POOL's count of pages handed out if
+   ALLOC is true, otherwise takes them off, and updates its peak.
+   Interrupts are turned off because the zeroed stock is used
+   without the pool's lock. */
+static void
+count_used (struct pool *pool, size_t page_cnt, bool alloc) {
+	enum intr_level old_level = intr_disable ();
+
+	if (alloc) {
+		pool->used_cnt += page_cnt;
+		if (pool->used_cnt > pool->used_peak)
+			pool->used_peak = pool->used_cnt;
+	} else
+		pool->used_cnt -= page_cnt;
+	intr_set_level (old_level);
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
+  /* We'll put the pool's used_map and page_info array at
+     *BM_BASE.  Calculate the space needed for them and advance
+     *BM_BASE past it. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
 	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
+	size_t info_pages =
+		DIV_ROUND_UP (pgcnt * sizeof *p->pages, PGSIZE) * PGSIZE;
+	int order;
 
 	lock_init(&p->lock);
 	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
 	p->base = (void *) start;
+	p->pages = *bm_base + bm_pages;
+	for (order = 0; order <= MAX_ORDER; order++) {
+		list_init (&p->free_lists[order]);
+		p->free_cnt[order] = 0;
+	}
+	p->zeroed_cnt = 0;
+	p->used_cnt = p->used_peak = 0;
 
 	// Mark all to unusable.
 	bitmap_set_all(p->used_map, true);
+	memset (p->pages, -1, pgcnt * sizeof *p->pages);
 
-	*bm_base += bm_pages;
+	*bm_base += bm_pages + info_pages;
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -356,3 +495,224 @@ page_from_pool (const struct pool *pool, void *page) {
 	size_t end_page = start_page + bitmap_size (pool->used_map);
 	return page_no >= start_page && page_no < end_page;
 }
+
+/* Removes and returns a page from POOL's stock of zeroed pages,
+   or returns a null pointer if the stock is empty. */
+static void *
+take_zeroed (struct pool *pool) {
+	enum intr_level old_level = intr_disable ();
+	void *page = NULL;
+
+	if (pool->zeroed_cnt > 0) {
+		page = pool->zeroed[--pool->zeroed_cnt];
+		pool->zero_hits++;
+	} else
+		pool->zero_misses++;
+	intr_set_level (old_level);
+	return page;
+}
+
+/* Returns all of POOL's zeroed pages to its bitmap, whose lock
+   must be held.  Returns true if there were any. */
+static bool
+release_zeroed (struct pool *pool) {
+	enum intr_level old_level;
+	bool released;
+
+	ASSERT (lock_held_by_current_thread (&pool->lock));
+
+	old_level = intr_disable ();
+	released = pool->zeroed_cnt > 0;
+	while (pool->zeroed_cnt > 0) {
+		void *page = pool->zeroed[--pool->zeroed_cnt];
+		buddy_free (pool, pg_no (page) - pg_no (pool->base), 1);
+	}
+	intr_set_level (old_level);
+	return released;
+}
+
+/* Takes a free page from POOL, zeroes it, and adds it to POOL's
+   stock of zeroed pages, if that is short.  Returns true if it
+   did.  Interrupts stay off while the pool's lock is held, so the
+   idle thread is never preempted holding it, and a lock held by
+   anyone else is simply skipped. */
+static bool
+refill_zeroed (struct pool *pool) {
+	enum intr_level old_level;
+	size_t page_idx = BITMAP_ERROR;
+	void *page;
+
+	old_level = intr_disable ();
+	if (pool->zeroed_cnt < ZEROED_MAX && lock_try_acquire (&pool->lock)) {
+		page_idx = buddy_alloc (pool, 1);
+		lock_release (&pool->lock);
+	}
+	intr_set_level (old_level);
+	if (page_idx == BITMAP_ERROR)
+		return false;
+
+	page = pool->base + PGSIZE * page_idx;
+	memset (page, 0, PGSIZE);
+
+	/* Only the idle thread adds pages, so there is still room. */
+	old_level = intr_disable ();
+	ASSERT (pool->zeroed_cnt < ZEROED_MAX);
+	pool->zeroed[pool->zeroed_cnt++] = page;
+	intr_set_level (old_level);
+	return true;
+}
+
+/* Returns the index of the page that E, an element of one of
+   POOL's free lists, belongs to. */
+static size_t
+info_idx (const struct pool *pool, struct list_elem *e) {
+	return list_entry (e, struct page_info, elem) - pool->pages;
+}
+
+/* Adds the block of 2**ORDER pages at PAGE_IDX to POOL's free
+   list for ORDER. */
+static void
+add_block (struct pool *pool, size_t page_idx, int order) {
+	struct page_info *info = &pool->pages[page_idx];
+
+	info->order = order;
+	list_push_front (&pool->free_lists[order], &info->elem);
+	pool->free_cnt[order]++;
+}
+
+/* Removes the free block of 2**ORDER pages at PAGE_IDX from
+   POOL's free list for ORDER. */
+static void
+remove_block (struct pool *pool, size_t page_idx, int order) {
+	struct page_info *info = &pool->pages[page_idx];
+
+	ASSERT (info->order == order);
+	info->order = -1;
+	list_remove (&info->elem);
+	pool->free_cnt[order]--;
+}
+
+/* Frees the block of 2**ORDER pages at PAGE_IDX in POOL, merging
+   it with its buddy, and the result with its buddy, and so on,
+   for as long as the buddy is a free block of the same order. */
+static void
+free_block (struct pool *pool, size_t page_idx, int order) {
+	size_t page_cnt = bitmap_size (pool->used_map);
+
+	while (order < MAX_ORDER) {
+		size_t buddy = page_idx ^ ((size_t) 1 << order);
+
+		if (buddy + ((size_t) 1 << order) > page_cnt
+				|| pool->pages[buddy].order != order)
+			break;
+		remove_block (pool, buddy, order);
+		page_idx &= ~((size_t) 1 << order);
+		order++;
+	}
+	add_block (pool, page_idx, order);
+}
+
+/* Frees the PAGE_CNT pages at PAGE_IDX in POOL, which need not
+   form a single block, by splitting them into the largest
+   aligned blocks they contain. */
+static void
+free_range (struct pool *pool, size_t page_idx, size_t page_cnt) {
+	while (page_cnt > 0) {
+		int order = 0;
+
+		while (order < MAX_ORDER
+				&& page_idx % ((size_t) 2 << order) == 0
+				&& ((size_t) 2 << order) <= page_cnt)
+			order++;
+		free_block (pool, page_idx, order);
+		page_idx += (size_t) 1 << order;
+		page_cnt -= (size_t) 1 << order;
+	}
+}
+
+/* Builds POOL's free lists from the free pages in its bitmap.
+   The lists end up in ascending address order, so that the pages
+   handed out first are low ones, which the boot page table maps
+   even before paging_init() has run. */
+static void
+init_free_lists (struct pool *pool) {
+	size_t page_cnt = bitmap_size (pool->used_map);
+	size_t start = 0;
+	int order;
+
+	while ((start = bitmap_scan (pool->used_map, start, 1, false))
+			!= BITMAP_ERROR) {
+		size_t end = bitmap_scan (pool->used_map, start, 1, true);
+
+		if (end == BITMAP_ERROR)
+			end = page_cnt;
+		free_range (pool, start, end - start);
+		start = end;
+	}
+	for (order = 0; order <= MAX_ORDER; order++)
+		list_reverse (&pool->free_lists[order]);
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL, whose lock must
+   be held, and returns the index of the first, or BITMAP_ERROR if
+   there is no free block large enough. */
+static size_t
+buddy_alloc (struct pool *pool, size_t page_cnt) {
+	size_t page_idx;
+	int order, k;
+
+	ASSERT (page_cnt > 0);
+
+	for (order = 0; ((size_t) 1 << order) < page_cnt; order++)
+		if (order == MAX_ORDER)
+			return BITMAP_ERROR;
+	for (k = order; list_empty (&pool->free_lists[k]); k++)
+		if (k == MAX_ORDER)
+			return BITMAP_ERROR;
+
+	page_idx = info_idx (pool, list_front (&pool->free_lists[k]));
+	remove_block (pool, page_idx, k);
+
+	/* Split the block down to ORDER, freeing the upper halves,
+	   then give back whatever lies past PAGE_CNT. */
+	while (k > order) {
+		k--;
+		add_block (pool, page_idx + ((size_t) 1 << k), k);
+	}
+	free_range (pool, page_idx + page_cnt, ((size_t) 1 << order) - page_cnt);
+
+	ASSERT (!bitmap_any (pool->used_map, page_idx, page_cnt));
+	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+	return page_idx;
+}
+
+/* Frees the PAGE_CNT pages at PAGE_IDX in POOL, whose lock must
+   be held. */
+static void
+buddy_free (struct pool *pool, size_t page_idx, size_t page_cnt) {
+	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
+	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	free_range (pool, page_idx, page_cnt);
+}
+
+/* Prints the free blocks of each order in POOL, and how much of
+   its free memory lies outside its largest free block, as a
+   measure of fragmentation. */
+static void
+print_pool_stats (const char *name, const struct pool *pool) {
+	size_t free_pages = 0, largest = 0;
+	int order;
+
+	printf ("Palloc: %s pool free blocks by order:", name);
+	for (order = 0; order <= MAX_ORDER; order++) {
+		printf (" %zu", pool->free_cnt[order]);
+		free_pages += pool->free_cnt[order] << order;
+		if (pool->free_cnt[order] > 0)
+			largest = (size_t) 1 << order;
+	}
+	printf ("\nPalloc: %s pool %zu pages free, largest block %zu, "
+			"%zu%% fragmented\n", name, free_pages, largest,
+			free_pages > 0 ? (free_pages - largest) * 100 / free_pages : 0);
+	printf ("Palloc: %s pool %zu pages in use, peak %zu\n",
+			name, pool->used_cnt, pool->used_peak);
+}
@@ -0,0 +1,264 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Object caches.  See slab.h for an overview.
+
+   A slab is one page.  It starts with a struct slab, followed by
+   the slab's colour offset and then its objects, each in a slot
+   of slot_size bytes.  Free objects are chained through a link
+   in their slot: at the start of the object if the cache has no
+   constructor, otherwise just past the object, so that freeing
+   an object does not undo its construction. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab0b1e
+
+/* Unused slabs a cache keeps before giving pages back. */
+#define EMPTY_MAX 1
+
+/* Slab header. */
+struct slab {
+	unsigned magic;             /* Always set to SLAB_MAGIC. */
+	struct kmem_cache *cache;   /* Owning cache. */
+	struct list_elem elem;      /* Element in one of cache's lists. */
+	void *free;                 /* First free object, or null. */
+	size_t in_use;              /* Objects handed out. */
+	uint8_t *objs;              /* First object. */
+};
+
+/* All caches, for statistics. */
+static struct list all_caches;
+static struct lock all_caches_lock;
+
+static struct slab *new_slab (struct kmem_cache *);
+static struct slab *obj_to_slab (struct kmem_cache *, void *obj);
+
+/* Initializes the list of caches. */
+void
+slab_init (void) {
+	list_init (&all_caches);
+	lock_init (&all_caches_lock);
+}
+
+/* Returns the free-list link of OBJ, an object of cache C. */
+static inline void **
+link_of (const struct kmem_cache *c, void *obj) {
+	return (void **) ((uint8_t *) obj + c->link_ofs);
+}
+
+/* Returns the size of the header at the start of each of C's
+   slabs, rounded up to C's alignment. */
+static inline size_t
+header_size (const struct kmem_cache *c) {
+	return ROUND_UP (sizeof (struct slab), c->align);
+}
+
+/* Creates and returns a cache named NAME for objects of SIZE
+   bytes aligned to ALIGN bytes, which must be a power of 2 or 0
+   for pointer alignment.  If CTOR is non-null, it is called on
+   each object once, when the slab holding it is created.
+   Returns a null pointer if memory is not available or if an
+   object of SIZE bytes does not fit in a slab. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, size_t align,
+		kmem_ctor_func *ctor) {
+	struct kmem_cache *c;
+	size_t body, leftover;
+
+	ASSERT (name != NULL);
+	ASSERT (size > 0);
+	ASSERT ((align & (align - 1)) == 0);
+
+	c = malloc (sizeof *c);
+	if (c == NULL)
+		return NULL;
+
+	c->name = name;
+	c->size = size;
+	c->align = align > sizeof (void *) ? align : sizeof (void *);
+	c->ctor = ctor;
+	if (ctor != NULL) {
+		c->link_ofs = ROUND_UP (size, sizeof (void *));
+		body = c->link_ofs + sizeof (void *);
+	} else {
+		c->link_ofs = 0;
+		body = size > sizeof (void *) ? size : sizeof (void *);
+	}
+	c->slot_size = ROUND_UP (body, c->align);
+	if (header_size (c) + c->slot_size > PGSIZE) {
+		free (c);
+		return NULL;
+	}
+	c->objs_per_slab = (PGSIZE - header_size (c)) / c->slot_size;
+	leftover = PGSIZE - header_size (c) - c->objs_per_slab * c->slot_size;
+	c->colour_max = leftover / c->align * c->align;
+	c->colour_next = 0;
+
+	lock_init (&c->lock);
+	list_init (&c->partial);
+	list_init (&c->full);
+	list_init (&c->empty);
+	c->slab_cnt = c->empty_cnt = c->obj_cnt = 0;
+
+	lock_acquire (&all_caches_lock);
+	list_push_back (&all_caches, &c->elem);
+	lock_release (&all_caches_lock);
+	return c;
+}
+
+/* Obtains and returns an object from cache C.  Returns a null
+   pointer if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c) {
+	struct slab *s;
+	void *obj;
+
+	ASSERT (c != NULL);
+
+	lock_acquire (&c->lock);
+	if (!list_empty (&c->partial))
+		s = list_entry (list_front (&c->partial), struct slab, elem);
+	else {
+		if (!list_empty (&c->empty)) {
+			s = list_entry (list_pop_front (&c->empty), struct slab, elem);
+			c->empty_cnt--;
+		} else {
+			s = new_slab (c);
+			if (s == NULL) {
+				lock_release (&c->lock);
+				return NULL;
+			}
+		}
+		list_push_front (&c->partial, &s->elem);
+	}
+
+	obj = s->free;
+	s->free = *link_of (c, obj);
+	s->in_use++;
+	c->obj_cnt++;
+	if (s->in_use == c->objs_per_slab) {
+		list_remove (&s->elem);
+		list_push_front (&c->full, &s->elem);
+	}
+	lock_release (&c->lock);
+	return obj;
+}
+
+/* Returns OBJ, which must have come from cache C, to C.  If C has
+   a constructor, OBJ must be in its constructed state.  Does
+   nothing if OBJ is null. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj) {
+	struct slab *s;
+
+	ASSERT (c != NULL);
+	if (obj == NULL)
+		return;
+
+	s = obj_to_slab (c, obj);
+#ifndef NDEBUG
+	/* Clear the object to help detect use-after-free bugs. */
+	if (c->ctor == NULL)
+		memset (obj, 0xcc, c->size);
+#endif
+
+	lock_acquire (&c->lock);
+	if (s->in_use == c->objs_per_slab) {
+		list_remove (&s->elem);
+		list_push_front (&c->partial, &s->elem);
+	}
+	*link_of (c, obj) = s->free;
+	s->free = obj;
+	s->in_use--;
+	c->obj_cnt--;
+
+	/* Keep a few unused slabs, with their objects constructed, and
+	   give the rest back. */
+	if (s->in_use == 0) {
+		list_remove (&s->elem);
+		if (c->empty_cnt < EMPTY_MAX) {
+			list_push_front (&c->empty, &s->elem);
+			c->empty_cnt++;
+		} else {
+			c->slab_cnt--;
+			s->magic = 0;
+			palloc_free_page (s);
+		}
+	}
+	lock_release (&c->lock);
+}
+
+/* Prints the objects in use, slabs and wasted bytes of every
+   cache.  Waste counts everything in a cache's slabs that is not
+   part of an object in use. */
+void
+slab_print_stats (void) {
+	struct list_elem *e;
+
+	lock_acquire (&all_caches_lock);
+	for (e = list_begin (&all_caches); e != list_end (&all_caches);
+			e = list_next (e)) {
+		struct kmem_cache *c = list_entry (e, struct kmem_cache, elem);
+
+		printf ("Slab %s: %zu objects of %zu bytes in %zu slabs, "
+				"%zu bytes wasted\n", c->name, c->obj_cnt, c->size,
+				c->slab_cnt, c->slab_cnt * PGSIZE - c->obj_cnt * c->size);
+	}
+	lock_release (&all_caches_lock);
+}
+
+/* Creates a slab for cache C, whose lock must be held, with all
+   of its objects free and constructed.  Returns a null pointer if
+   memory is not available. */
+static struct slab *
+new_slab (struct kmem_cache *c) {
+	struct slab *s;
+	size_t i;
+
+	s = palloc_get_page (0);
+	if (s == NULL)
+		return NULL;
+
+	s->magic = SLAB_MAGIC;
+	s->cache = c;
+	s->in_use = 0;
+	s->objs = (uint8_t *) s + header_size (c) + c->colour_next;
+	c->colour_next += c->align;
+	if (c->colour_next > c->colour_max)
+		c->colour_next = 0;
+
+	s->free = NULL;
+	for (i = c->objs_per_slab; i-- > 0; ) {
+		void *obj = s->objs + i * c->slot_size;
+
+		if (c->ctor != NULL)
+			c->ctor (obj);
+		*link_of (c, obj) = s->free;
+		s->free = obj;
+	}
+	c->slab_cnt++;
+	return s;
+}
+
+/* Returns the slab that OBJ, an object of cache C, is in. */
+static struct slab *
+obj_to_slab (struct kmem_cache *c, void *obj) {
+	struct slab *s = pg_round_down (obj);
+
+	/* Check that the slab is valid. */
+	ASSERT (s->magic == SLAB_MAGIC);
+	ASSERT (s->cache == c);
+
+	/* Check that the object is properly aligned for the slab. */
+	ASSERT ((uint8_t *) obj >= s->objs);
+	ASSERT (((uint8_t *) obj - s->objs) % c->slot_size == 0);
+
+	return s;
+}
@@ -0,0 +1,65 @@
+#include "threads/spinlock.h"
+#include <debug.h>
+#include <stddef.h>
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+
+/* Initializes LOCK, named NAME for debugging, as not held. */
+void
+spinlock_init (struct spinlock *lock, const char *name) {
+	ASSERT (lock != NULL);
+
+	lock->locked = 0;
+	lock->cpu = NULL;
+	lock->name = name;
+}
+
+/* Acquires LOCK, spinning until it is free, and turns interrupts
+   off until the running CPU releases its last spin lock.  LOCK
+   must not already be held by the running CPU.
+
+   The interrupts-off window is charged to our caller, so that the
+   -intrprof profile still names the code that took the lock. */
+void
+spinlock_acquire (struct spinlock *lock) {
+	enum intr_level old_level =
+		intr_disable_at ((uintptr_t) __builtin_return_address (0));
+	struct cpu *cpu = this_cpu ();
+
+	ASSERT (lock->cpu != cpu || !lock->locked);
+
+	if (cpu->lock_depth++ == 0)
+		cpu->lock_intr = old_level;
+
+	/* Test-and-test-and-set, so that waiting CPUs spin on their
+	   own copy of the cache line instead of bouncing it. */
+	while (__atomic_exchange_n (&lock->locked, 1, __ATOMIC_ACQUIRE))
+		while (lock->locked)
+			asm volatile ("pause");
+	lock->cpu = cpu;
+}
+
+/* Releases LOCK, which the running CPU must hold.  Turns
+   interrupts back on if this was the CPU's last spin lock and
+   they were on when it took the first. */
+void
+spinlock_release (struct spinlock *lock) {
+	struct cpu *cpu = this_cpu ();
+
+	ASSERT (spinlock_held (lock));
+	ASSERT (cpu->lock_depth > 0);
+
+	lock->cpu = NULL;
+	__atomic_store_n (&lock->locked, 0, __ATOMIC_RELEASE);
+	if (--cpu->lock_depth == 0)
+		intr_set_level (cpu->lock_intr);
+}
+
+/* Returns true if the running CPU holds LOCK, false otherwise.
+   (Testing whether some other CPU holds it would be racy.) */
+bool
+spinlock_held (const struct spinlock *lock) {
+	ASSERT (lock != NULL);
+
+	return lock->locked && lock->cpu == this_cpu ();
+}
@@ -33,6 +33,82 @@
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 
+static void take_lock (struct lock *);
+static void list_held (struct lock *);
+static heap_less_func donor_less;
+static heap_less_func waiter_less;
+
+/* Semaphores and locks have a fast path that uses only the
+   atomic instructions below, without turning interrupts off, for
+   the common case where no thread has to wait.  Everything else
+   is done with interrupts off, as before, which on our single CPU
+   also keeps those instructions from running in the middle of
+   it. */
+
+/* Atomically sets *P to NEW if it holds OLD.  Returns true if it
+   did. */
+static inline bool
+cas (unsigned *p, unsigned old, unsigned new) {
+	unsigned prev;
+	asm volatile ("lock cmpxchgl %2, %1"
+			: "=a" (prev), "+m" (*p)
+			: "r" (new), "0" (old)
+			: "memory");
+	return prev == old;
+}
+
+/* Atomically increments *P. */
+static inline void
+atomic_inc (unsigned *p) {
+	asm volatile ("lock incl %0" : "+m" (*p) : : "memory");
+}
+
+/* Initializes WQ as an empty wait queue. */
+void
+waitq_init (struct waitq *wq) {
+	heap_init (&wq->waiters, waiter_less, NULL);
+}
+
+/* Returns true if no thread is waiting in WQ. */
+bool
+waitq_empty (const struct waitq *wq) {
+	return heap_empty (&wq->waiters);
+}
+
+/* Adds T to WQ.  T must not be waiting in another wait queue. */
+void
+waitq_push (struct waitq *wq, struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (t->waitq == NULL);
+
+	t->waitq = wq;
+	heap_insert (&wq->waiters, &t->waitq_elem);
+}
+
+/* Removes and returns the thread in WQ with the highest priority,
+   or the one that has waited longest among several.  WQ must not
+   be empty. */
+struct thread *
+waitq_pop (struct waitq *wq) {
+	struct thread *t;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	t = heap_entry (heap_pop_min (&wq->waiters), struct thread, waitq_elem);
+	t->waitq = NULL;
+	return t;
+}
+
+/* Removes T, which must be waiting in WQ, from WQ. */
+void
+waitq_remove (struct waitq *wq, struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (t->waitq == wq);
+
+	heap_remove (&wq->waiters, &t->waitq_elem);
+	t->waitq = NULL;
+}
+
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
    manipulating it:
@@ -47,7 +123,21 @@ sema_init (struct semaphore *sema, unsigned value) {
 	ASSERT (sema != NULL);
 
 	sema->value = value;
-	list_init (&sema->waiters);
+	waitq_init (&sema->waiters);
+	sema->handoff = false;
+}
+
+/* Sets whether sema_up() on SEMA hands the CPU directly to the
+   thread it wakes, if that thread would run next anyway (see
+   thread_handoff()).  This saves a trip through the run queue
+   for a producer and consumer passing control back and forth,
+   at the cost of the waker giving up the rest of its time slice
+   to a thread of equal priority.  Off by default. */
+void
+sema_set_handoff (struct semaphore *sema, bool handoff) {
+	ASSERT (sema != NULL);
+
+	sema->handoff = handoff;
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -66,10 +156,12 @@ sema_down (struct semaphore *sema) {
 	ASSERT (sema != NULL);
 	ASSERT (!intr_context ());
 
+	if (sema_try_down (sema))
+		return;
+
 	old_level = intr_disable ();
 	while (sema->value == 0) {//?
-		//list_push_back (&sema->waiters, &thread_current ()->elem);
-    list_insert_ordered(&sema->waiters, &thread_current ()->elem, &cmp_priority, NULL);
+		waitq_push (&sema->waiters, thread_current ());
 		thread_block (); //schedule 까지 수행
 	}
 	sema->value--;
@@ -83,22 +175,14 @@ sema_down (struct semaphore *sema) {
    This function may be called from an interrupt handler. */
 bool
 sema_try_down (struct semaphore *sema) {
-	enum intr_level old_level;
-	bool success;
+	unsigned value;
 
 	ASSERT (sema != NULL);
 
-	old_level = intr_disable ();
-	if (sema->value > 0)
-	{
-		sema->value--;
-		success = true;
-	}
-	else
-		success = false;
-	intr_set_level (old_level);
-
-	return success;
+	while ((value = sema->value) > 0)
+		if (cas (&sema->value, value, value - 1))
+			return true;
+	return false;
 }
 
 /* Up or "V" operation on a semaphore.  Increments SEMA's value
@@ -111,14 +195,22 @@ sema_up (struct semaphore *sema) {
 
 	ASSERT (sema != NULL);
 
+	/* A thread that finds the value 0 queues itself with
+	   interrupts off, so it is either in the queue already or
+	   will see the new value. */
+	atomic_inc (&sema->value);
+	if (waitq_empty (&sema->waiters))
+		return;
+
 	old_level = intr_disable ();
-	if (!list_empty (&sema->waiters))
-  { 
-      list_sort(&sema->waiters, &cmp_priority, NULL);
-		thread_unblock (list_entry (list_pop_front (&sema->waiters),
-					struct thread, elem));
-  }
-  sema->value++;
+	if (!waitq_empty (&sema->waiters)) {
+		struct thread *t = waitq_pop (&sema->waiters);
+
+		if (sema->handoff)
+			thread_handoff (t);
+		else
+			thread_unblock (t);
+	}
   test_max_priority();
   //? thread_unblock으로 ready_list에 추가한 친구가 running_thread의
   //? priority보다 클 경우 priority preemption 진행
@@ -185,6 +277,17 @@ lock_init (struct lock *lock) {
 
 	lock->holder = NULL;
 	sema_init (&lock->semaphore, 1);
+	heap_init (&lock->donors, donor_less, NULL);
+	lock->contended = false;
+}
+
+/* Sets whether lock_release() on LOCK hands the CPU directly to
+   the waiter it wakes.  See sema_set_handoff(). */
+void
+lock_set_handoff (struct lock *lock, bool handoff) {
+	ASSERT (lock != NULL);
+
+	sema_set_handoff (&lock->semaphore, handoff);
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -196,33 +299,34 @@ lock_init (struct lock *lock) {
    interrupts disabled, but interrupts will be turned back on if
    we need to sleep. */
 void
-lock_acquire (struct lock *lock) {//? try to acquire
-/* 해당 lock 의 holder가 존재 한다면 아래 작업을 수행한다. */
-/* 현재 스레드의 wait_on_lock 변수에 획득 하기를 기다리는 lock의 주소를 저장 */
-/* multiple donation 을 고려하기 위해 이전상태의 우선순위를 기억,
-donation 을 받은 스레드의 thread 구조체를 list로 관리한다. */
-/* priority donation 수행하기 위해 donate_priority() 함수 호출 */
+lock_acquire (struct lock *lock) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
 
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (!lock_held_by_current_thread (lock));
 
-  struct thread* curr = thread_current(); // pri 6
-  struct thread* lock_holder = lock->holder; // main
+	if (sema_try_down (&lock->semaphore)) {
+		take_lock (lock);
+		return;
+	}
 
-  if(lock_holder != NULL){
-    curr->wait_on_lock = lock;
-    // if(lock_holder->priority < curr->priority)
-    //   lock_holder->priority = curr->priority;
-    
-    list_insert_ordered(&(lock_holder->donations), &curr->donation_elem, &cmp_priority, NULL);
-    donate_priority(); 
-  }
+	/* The lock is held: join its donors and pass our priority on
+	   to the holder, and to whoever it is waiting for.  The holder
+	   may not have stored itself in `holder' yet, in which case
+	   take_lock() will find us among the donors. */
+	old_level = intr_disable ();
+	if (!thread_mlfqs) {
+		curr->wait_on_lock = lock;
+		heap_insert (&lock->donors, &curr->donor_elem);
+		list_held (lock);
+		donate_priority (curr);
+	}
+	intr_set_level (old_level);
 
 	sema_down (&lock->semaphore);
-  curr->wait_on_lock = NULL;
-
-	lock->holder = curr;
+	take_lock (lock);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -240,10 +344,51 @@ lock_try_acquire (struct lock *lock) {
 
 	success = sema_try_down (&lock->semaphore);
 	if (success)
-		lock->holder = thread_current ();
+		take_lock (lock);
 	return success;
 }
 
+/* Makes the current thread the holder of LOCK, which it has just
+   downed.  Under priority donation, the new holder leaves the
+   lock's donors, if it was one, and takes on the priority of
+   those still waiting.  If there are none, this is just a
+   store. */
+static void
+take_lock (struct lock *lock) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	lock->holder = curr;
+	if (thread_mlfqs
+			|| (curr->wait_on_lock != lock && heap_empty (&lock->donors)))
+		return;
+
+	old_level = intr_disable ();
+	if (curr->wait_on_lock == lock) {
+		heap_remove (&lock->donors, &curr->donor_elem);
+		curr->wait_on_lock = NULL;
+	}
+	if (!heap_empty (&lock->donors)) {
+		list_held (lock);
+		refresh_priority ();
+	}
+	intr_set_level (old_level);
+}
+
+/* Puts LOCK, which has waiters, on its holder's held_locks so
+   that the holder takes on their priority, unless it is there
+   already or the lock is between holders.  Only contended locks
+   are kept on held_locks.  Interrupts must be off. */
+static void
+list_held (struct lock *lock) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!lock->contended && lock->holder != NULL) {
+		list_push_back (&lock->holder->held_locks, &lock->elem);
+		lock->contended = true;
+	}
+}
+
 /* Releases LOCK, which must be owned by the current thread.
    This is lock_release function.
 
@@ -252,15 +397,30 @@ lock_try_acquire (struct lock *lock) {
    handler. */
 void
 lock_release (struct lock *lock) {
+	enum intr_level old_level;
+
 	ASSERT (lock != NULL);
 	ASSERT (lock_held_by_current_thread (lock));
 
+	/* Clearing `holder' first means that a thread that starts
+	   waiting after we look at `contended' does not put the lock
+	   on our held_locks. */
 	lock->holder = NULL;
+	barrier ();
+	if (!lock->contended) {
+		sema_up (&lock->semaphore);
+		return;
+	}
 
-  remove_with_lock(lock);
-  refresh_priority();
-
+	/* Give back whatever the lock's waiters donated.  They stay
+	   in its donors and donate to the next holder instead. */
+	old_level = intr_disable ();
+	list_remove (&lock->elem);
+	lock->contended = false;
+	refresh_priority ();
 	sema_up (&lock->semaphore);
+	test_max_priority ();
+	intr_set_level (old_level);
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -273,18 +433,209 @@ lock_held_by_current_thread (const struct lock *lock) {
 	return lock->holder == thread_current ();
 }
 
-/* One semaphore in a list. */
-struct semaphore_elem {
-	struct list_elem elem;              /* List element. */
-	struct semaphore semaphore;         /* This semaphore. */
-};
-
-/*하지만 이렇게 되면 cond_wait가 호출 된 후 cond_signal이 호출 됐는데, 
-  먼저 호출된 cond_wait에서 signal을 받지 못하는 경우가 있을 수 있다. 
-  왜냐면 lock_release를 하고 sema_down을 하게 될 텐데, lock_release 
-  직후에 다른 thread가 스케쥴링되고 그 thread에서 cond_signal하게 되면 
-  semaphore에 waiter가 없으므로 sema_up을 하지 않을테고 먼저의 thread는 
-  signal을 받지 못하는 경우가 생길 수 있다.*/
+/* Initializes LOCK as a priority-ceiling lock with the given
+   CEILING.  See synch.h. */
+void
+ceiling_lock_init (struct ceiling_lock *lock, int ceiling) {
+	ASSERT (lock != NULL);
+	ASSERT (PRI_MIN <= ceiling && ceiling <= PRI_MAX);
+
+	lock->holder = NULL;
+	sema_init (&lock->semaphore, 1);
+	lock->ceiling = ceiling;
+}
+
+/* Acquires LOCK, first raising the current thread to LOCK's
+   ceiling, then sleeping until LOCK becomes available if its
+   holder is asleep.  The lock must not already be held by the
+   current thread.
+
+   LOCK's list element belongs to its holder's ceiling_locks, so
+   a waiter is raised through its wait_ceiling instead, and only
+   links LOCK into its own list once it holds it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+ceiling_lock_acquire (struct ceiling_lock *lock) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (lock != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (!ceiling_lock_held_by_current_thread (lock));
+	ASSERT (curr->wait_ceiling == PRI_MIN);
+
+	old_level = intr_disable ();
+	curr->wait_ceiling = lock->ceiling;
+	if (!thread_mlfqs && lock->ceiling > curr->priority)
+		refresh_priority ();
+	intr_set_level (old_level);
+
+	sema_down (&lock->semaphore);
+
+	old_level = intr_disable ();
+	lock->holder = curr;
+	list_push_back (&curr->ceiling_locks, &lock->elem);
+	curr->wait_ceiling = PRI_MIN;
+	intr_set_level (old_level);
+}
+
+/* Releases LOCK, which must be owned by the current thread, and
+   drops back to the priority the thread would have without it.
+
+   An interrupt handler cannot acquire a lock, so it does not
+   make sense to try to release a lock within an interrupt
+   handler. */
+void
+ceiling_lock_release (struct ceiling_lock *lock) {
+	enum intr_level old_level;
+
+	ASSERT (lock != NULL);
+	ASSERT (ceiling_lock_held_by_current_thread (lock));
+
+	lock->holder = NULL;
+	old_level = intr_disable ();
+	list_remove (&lock->elem);
+	if (!thread_mlfqs)
+		refresh_priority ();
+	sema_up (&lock->semaphore);
+	test_max_priority ();
+	intr_set_level (old_level);
+}
+
+/* Returns true if the current thread holds LOCK, false
+   otherwise. */
+bool
+ceiling_lock_held_by_current_thread (const struct ceiling_lock *lock) {
+	ASSERT (lock != NULL);
+
+	return lock->holder == thread_current ();
+}
+
+/* Initializes RW as an unheld reader-writer lock. */
+void
+rwlock_init (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	lock_init (&rw->gate);
+	rw->readers = 0;
+	list_init (&rw->holds);
+	rw->drainer = NULL;
+	sema_init (&rw->drained, 0);
+}
+
+/* Acquires RW in shared mode, sleeping while a writer holds it or
+   is waiting for it.  The current thread must not already hold
+   RW, in either mode, and may hold at most RWLOCK_READ_MAX
+   reader-writer locks shared at once.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_read_acquire (struct rwlock *rw) {
+	struct thread *curr = thread_current ();
+	struct rwlock_hold *hold = NULL;
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+
+	lock_acquire (&rw->gate);
+
+	old_level = intr_disable ();
+	for (int i = 0; i < RWLOCK_READ_MAX; i++) {
+		ASSERT (curr->read_holds[i].rwlock != rw);
+		if (hold == NULL && curr->read_holds[i].rwlock == NULL)
+			hold = &curr->read_holds[i];
+	}
+	ASSERT (hold != NULL);
+	hold->rwlock = rw;
+	hold->thread = curr;
+	list_push_back (&rw->holds, &hold->elem);
+	rw->readers++;
+	intr_set_level (old_level);
+
+	lock_release (&rw->gate);
+}
+
+/* Releases RW, which the current thread must hold in shared
+   mode.  The last reader out wakes the writer waiting for it, if
+   any. */
+void
+rwlock_read_release (struct rwlock *rw) {
+	struct thread *curr = thread_current ();
+	struct rwlock_hold *hold = NULL;
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+
+	old_level = intr_disable ();
+	for (int i = 0; i < RWLOCK_READ_MAX; i++)
+		if (curr->read_holds[i].rwlock == rw)
+			hold = &curr->read_holds[i];
+	ASSERT (hold != NULL);
+	list_remove (&hold->elem);
+	hold->rwlock = NULL;
+	rw->readers--;
+
+	/* Give back what the waiting writer donated. */
+	if (!thread_mlfqs)
+		refresh_priority ();
+	if (rw->readers == 0 && rw->drainer != NULL)
+		sema_up (&rw->drained);
+	intr_set_level (old_level);
+}
+
+/* Acquires RW in exclusive mode, sleeping until no other thread
+   holds it.  From the time it starts waiting, no new readers get
+   in.  The current thread must not already hold RW, in either
+   mode.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_write_acquire (struct rwlock *rw) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+
+	lock_acquire (&rw->gate);
+
+	/* Wait for the readers already in to leave, donating our
+	   priority to them in the meantime. */
+	old_level = intr_disable ();
+	if (rw->readers > 0) {
+		rw->drainer = curr;
+		curr->wait_on_rwlock = rw;
+		if (!thread_mlfqs)
+			donate_priority (curr);
+		sema_down (&rw->drained);
+		curr->wait_on_rwlock = NULL;
+		rw->drainer = NULL;
+	}
+	intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread must hold in exclusive
+   mode. */
+void
+rwlock_write_release (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	lock_release (&rw->gate);
+}
+
+/* Returns true if the current thread holds RW in exclusive mode,
+   false otherwise. */
+bool
+rwlock_write_held_by_current_thread (const struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	return lock_held_by_current_thread (&rw->gate);
+}
 
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
@@ -293,7 +644,7 @@ void
 cond_init (struct condition *cond) {
 	ASSERT (cond != NULL);
 
-	list_init (&cond->waiters);
+	waitq_init (&cond->waiters);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -318,28 +669,38 @@ cond_init (struct condition *cond) {
    we need to sleep. */
 void
 cond_wait (struct condition *cond, struct lock *lock) {
-	/*
-  struct semaphore_elem {
-	struct list_elem elem;    
-	struct semaphore semaphore;
-  };
-  */
-  struct semaphore_elem waiter;
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
 
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	sema_init (&waiter.semaphore, 0);
-	//list_push_back (&cond->waiters, &waiter.elem);
-  list_insert_ordered(&cond->waiters, &waiter.elem, &cmp_sem_priority, NULL);
-	
+	/* Releasing LOCK may let a higher-priority thread run and
+	   signal us before we block, so a signal is a thread taking
+	   us out of COND's queue, rather than waking us up. */
+	old_level = intr_disable ();
+	waitq_push (&cond->waiters, curr);
 	lock_release (lock);
-	sema_down (&waiter.semaphore);//
+	while (curr->waitq == &cond->waiters)
+		thread_block ();
+	intr_set_level (old_level);
+
 	lock_acquire (lock);
 }
 
+/* Takes the highest-priority thread out of COND's queue and wakes
+   it up if it has already gone to sleep.  Interrupts must be
+   off. */
+static void
+cond_wake_one (struct condition *cond) {
+	struct thread *t = waitq_pop (&cond->waiters);
+
+	if (t->status == THREAD_BLOCKED)
+		thread_unblock (t);
+}
+
 /* If any threads are waiting on COND (protected by LOCK), then
    this function signals one of them to wake up from its wait.
    LOCK must be held before calling this function.
@@ -349,16 +710,18 @@ cond_wait (struct condition *cond, struct lock *lock) {
    interrupt handler. */
 void
 cond_signal (struct condition *cond, struct lock *lock UNUSED) {
+	enum intr_level old_level;
+
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	if (!list_empty (&cond->waiters)){
-      list_sort(&cond->waiters, &cmp_sem_priority, NULL); //?
-		sema_up (&list_entry (list_pop_front (&cond->waiters),
-					struct semaphore_elem, elem)->semaphore);
-  }
+	old_level = intr_disable ();
+	if (!waitq_empty (&cond->waiters))
+		cond_wake_one (cond);
+	test_max_priority ();
+	intr_set_level (old_level);
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -369,38 +732,38 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED) {
    interrupt handler. */
 void
 cond_broadcast (struct condition *cond, struct lock *lock) {
+	enum intr_level old_level;
+
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (lock_held_by_current_thread (lock));
 
-	while (!list_empty (&cond->waiters))
-		cond_signal (cond, lock);
+	old_level = intr_disable ();
+	while (!waitq_empty (&cond->waiters))
+		cond_wake_one (cond);
+	test_max_priority ();
+	intr_set_level (old_level);
 }
 
+/* Orders the donors of a lock so that the heap's least element is
+   the waiter with the highest priority. */
+static bool
+donor_less (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = heap_entry (a_, struct thread, donor_elem);
+	const struct thread *b = heap_entry (b_, struct thread, donor_elem);
 
-bool cmp_sem_priority (const struct list_elem *a, const struct list_elem *b, void *aux){
-  /*
-    struct semaphore_elem {
-      struct list_elem elem;
-      struct semaphore semaphore;
-    };
-  */
-  struct semaphore_elem *sa = list_entry(a, struct semaphore_elem, elem);
-  struct semaphore_elem *sb = list_entry(b, struct semaphore_elem, elem);
-  
-  struct list_elem* elem_a = list_begin(&(sa->semaphore).waiters);
-  struct list_elem* elem_b = list_begin(&(sb->semaphore).waiters);
-
-  struct thread* thread_a = list_entry(elem_a, struct thread, elem);
-  struct thread* thread_b = list_entry(elem_b, struct thread, elem);
-
-  return thread_a->priority > thread_b->priority;
+	return a->priority > b->priority;
 }
 
-bool cmp_priority(const struct list_elem *a, const struct list_elem *b, void *aux){
-	struct thread* t_a;
-	struct thread* t_b;
-	t_a = list_entry(a, struct thread, elem);
-	t_b = list_entry(b, struct thread, elem);
+/* Orders the threads in a wait queue so that the heap's least
+   element is the waiter with the highest priority. */
+static bool
+waiter_less (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = heap_entry (a_, struct thread, waitq_elem);
+	const struct thread *b = heap_entry (b_, struct thread, waitq_elem);
 
-	return t_a->priority > t_b->priority;
-}
\ No newline at end of file
+	return a->priority > b->priority;
+}
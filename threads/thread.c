@@ -2,14 +2,19 @@
 #include <debug.h>
 #include <stddef.h>
 #include <random.h>
+#include <rusage.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/spinlock.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -24,15 +29,60 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-
-/*List of sleep thread*/
-static struct list sleep_list;
-
-/* Idle thread. */
-static struct thread *idle_thread;
+/* Per-CPU state.  See cpu.h. */
+struct cpu cpus[CPU_MAX];
+int cpu_cnt = 1;
+
+/* Scheduler locks.  rq_lock protects the run queues and the EDF
+   class below, and the trace ring.  A thread that switches away
+   holds it across switch_to(), and the thread switched to
+   releases it, so that no other CPU can pick up the outgoing
+   thread before its registers are saved.  all_lock protects
+   all_list and dirty_list, and page_cache_lock the page cache.
+   all_lock is taken before rq_lock, and rq_lock before
+   page_cache_lock, when more than one is needed. */
+static struct spinlock rq_lock;
+static struct spinlock all_lock;
+static struct spinlock page_cache_lock;
+
+/* Run queue of processes in THREAD_READY state, that is,
+   processes that are ready to run but not actually running.
+   There is one FIFO list per priority level, and bit P of
+   ready_mask is set iff ready_queues[P] is nonempty, so the
+   highest ready priority is the most significant set bit. */
+#if PRI_MIN != 0 || PRI_MAX > 63
+#error The run queue bitmap needs priorities in [0, 63].
+#endif
+static struct list ready_queues[PRI_MAX + 1];
+static uint64_t ready_mask;
+static int ready_cnt;           /* # of threads in the run queue. */
+
+/* Earliest-deadline-first class.  A thread in it runs ahead of
+   every thread in the priority class, earliest absolute deadline
+   first, as long as its current job has budget left.  A thread
+   that uses up its budget is throttled: until its next period
+   starts it is scheduled by its priority like any other thread.
+   Admission control keeps the bandwidth reserved by all EDF
+   threads, in thousandths of a CPU, at or below
+   EDF_BANDWIDTH_MAX, so that each of them gets its runtime by its
+   deadline. */
+#define EDF_BANDWIDTH_MAX 950
+static struct heap edf_ready;   /* Ready, unthrottled EDF threads. */
+static struct list edf_list;    /* All EDF threads. */
+static int edf_bandwidth;       /* Bandwidth reserved. */
+static int64_t edf_next_release; /* Earliest release of a throttled thread. */
+
+/* List of all processes.  Processes are added to this list
+   when they are created and removed when they exit. */
+static struct list all_list;
+
+/* Threads that have received CPU time since the last MLFQS
+   priority refresh, and so may have a stale priority.  Only
+   used with -mlfqs. */
+static struct list dirty_list;
+
+/* Sleeping threads, ordered by wakeup_tick. */
+static struct heap sleep_heap;
 
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
@@ -40,33 +90,109 @@ static struct thread *initial_thread;
 /* Lock used by allocate_tid(). */
 static struct lock tid_lock;
 
-/* Thread destruction requests */
-static struct list destruction_req;
-
-/* Statistics. */
-static long long idle_ticks;    /* # of timer ticks spent idle. */
-static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
-static long long user_ticks;    /* # of timer ticks in user programs. */
+/* Pages of threads that have exited, most recently freed first.
+   switch_finish() pushes the page of a dying thread here once
+   its CPU has switched away from it, and thread_create() reuses
+   these pages before asking palloc for a new one.  Pages beyond
+   THREAD_CACHE_MAX are handed back to palloc by the reaper thread,
+   so that the scheduler never frees memory with interrupts off. */
+static struct list page_cache;
+static size_t page_cache_cnt;
+#define THREAD_CACHE_MAX 32
+
+/* Bytes cleared at the top of a thread's stack when its page is
+   reused, so that stale return addresses do not show up in
+   backtraces. */
+#define STACK_CLEAR 64
+
+/* Reaper thread, which frees excess cached thread pages. */
+static struct thread *reaper_thread;
+static void reaper (void *aux);
+static struct thread *alloc_thread_page (void);
+
+/* Thread page statistics. */
+static long long pages_recycled;  /* # of thread pages reused. */
+static long long pages_fresh;     /* # of thread pages from palloc. */
+static long long pages_reaped;    /* # of thread pages freed by the reaper. */
 
 static long long next_tick_to_awake;
 
+/* Why the running thread gave up the CPU. */
+enum sched_reason {
+	SCHED_YIELD,                /* Called thread_yield(). */
+	SCHED_PREEMPT,              /* Time slice expired or preempted. */
+	SCHED_BLOCK,                /* Blocked. */
+	SCHED_EXIT,                 /* Exited. */
+	SCHED_HANDOFF               /* Handed the CPU to a thread it woke. */
+};
+
+/* Context-switch trace ring.  One entry is recorded for every
+   schedule() that switches threads, and the oldest entry is
+   overwritten once the ring is full.  thread_dump_sched() prints
+   the raw entries in hex; utils/schedtrace decodes them, so the
+   layout here must match the one there. */
+struct sched_event {
+	uint64_t tsc;               /* Time stamp counter at the switch. */
+	uint64_t wait;              /* Cycles NEXT spent in the run queue. */
+	int32_t prev;               /* Thread switched from. */
+	int32_t next;               /* Thread switched to. */
+	uint8_t reason;             /* Why PREV stopped (enum sched_reason). */
+	uint8_t prev_priority;      /* PREV's priority. */
+	uint8_t next_priority;      /* NEXT's priority. */
+	uint8_t pad[5];
+};
+
+#define SCHED_TRACE_CNT 1024    /* Entries in the trace ring. */
+static struct sched_event sched_trace[SCHED_TRACE_CNT];
+static uint64_t sched_trace_total; /* # of entries ever recorded. */
+static bool sched_trace_paused; /* Set while the ring is being dumped. */
+
+/* Multi-level feedback queue scheduler. */
+#define PRI_REFRESH 4           /* # of timer ticks between priority refreshes. */
+static fixed_t load_avg;        /* System load average. */
+static int refresh_max;         /* Most threads touched by one refresh. */
+static long long mlfqs_ticks;   /* # of calls to mlfqs_tick(). */
+static uint64_t mlfqs_cycles;   /* TSC cycles spent in mlfqs_tick(). */
+static uint64_t mlfqs_cycles_max; /* Most cycles spent in one call. */
+
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
-static unsigned thread_ticks;   /* # of timer ticks since last yield. */
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* Maximum length of a nested donation chain. */
+int donate_depth = 8;
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
 static struct thread *next_thread_to_run (void);
 static void init_thread (struct thread *, const char *name, int priority);
-static void do_schedule(int status);
-static void schedule (void);
+void switch_threads (uint64_t *cur_rsp, uint64_t next_rsp,
+		struct intr_frame *next_tf);
+static void do_schedule(int status, enum sched_reason);
+static void schedule (enum sched_reason);
+static void switch_to (struct thread *next, enum sched_reason);
+static void yield (enum sched_reason);
 static tid_t allocate_tid (void);
+static void ready_push (struct thread *);
+static void ready_remove (struct thread *);
+static void thread_requeue (struct thread *, int priority);
+static int effective_priority (struct thread *);
+static void change_priority (struct thread *, int priority);
+static bool edf_queued (const struct thread *);
+static bool edf_less (const struct heap_elem *, const struct heap_elem *,
+		void *aux);
+static void edf_tick (struct thread *);
+static void edf_leave (struct thread *);
+static void mlfqs_tick (struct thread *);
+static void mlfqs_update_priority (struct thread *);
+static bool is_idle (const struct thread *);
+static void switch_finish (void);
+static heap_less_func wakeup_less;
 
 /* Returns true if T appears to point to a valid thread. */
 
@@ -74,11 +200,20 @@ static tid_t allocate_tid (void);
 //생성될 때 THREAD_MAGIC(0xcd6abf4b)으로 설정. 스택 오버플로우 발생 시 이 값이 변한다.
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
 
+/* Returns true if T is the idle thread of the CPU it runs on.
+   Idle threads never move between CPUs. */
+static bool
+is_idle (const struct thread *t) {
+	return t->cpu != NULL && t->cpu->idle == t;
+}
+
 /* Returns the running thread.
  * Read the CPU's stack pointer `rsp', and then round that
  * down to the start of a page.  Since `struct thread' is
  * always at the beginning of a page and the stack pointer is
- * somewhere in the middle, this locates the curent thread. */
+ * somewhere in the middle, this locates the curent thread.
+ * Each CPU runs on its own thread's stack, so this is the
+ * running thread of whichever CPU calls it. */
 #define running_thread() ((struct thread *) (pg_round_down (rrsp ())))
 
 
@@ -116,19 +251,38 @@ thread_init (void) {
 	lgdt (&gdt_ds);
 
 	/* Init the globla thread context */
+	for (int i = 0; i < CPU_MAX; i++)
+		cpus[i].id = i;
+	spinlock_init (&rq_lock, "rq");
+	spinlock_init (&all_lock, "all");
+	spinlock_init (&page_cache_lock, "page_cache");
 	lock_init (&tid_lock);
-	list_init (&ready_list);
-	list_init (&destruction_req);
-	list_init (&sleep_list);
+	for (int pri = PRI_MIN; pri <= PRI_MAX; pri++)
+		list_init (&ready_queues[pri]);
+	ready_mask = 0;
+	ready_cnt = 0;
+	heap_init (&edf_ready, edf_less, NULL);
+	list_init (&edf_list);
+	edf_bandwidth = 0;
+	edf_next_release = INT64_MAX;
+	list_init (&all_list);
+	list_init (&dirty_list);
+	list_init (&page_cache);
+	page_cache_cnt = 0;
+	heap_init (&sleep_heap, wakeup_less, NULL);
 
 	next_tick_to_awake = INT64_MAX;
+	load_avg = 0;
 
 	/* Set up a thread structure for the running thread. */
 	//#define running_thread() ((struct thread *) (pg_round_down (rrsp ())))
 	initial_thread = running_thread ();
 	init_thread (initial_thread, "main", PRI_DEFAULT);
+	initial_thread->cpu = &cpus[0];
+	list_push_back (&all_list, &initial_thread->all_elem);
 	initial_thread->status = THREAD_RUNNING; 
 	initial_thread->tid = allocate_tid (); 
+	initial_thread->run_stamp = rdtsc ();
 }
 
 /* Starts preemptive thread scheduling by enabling interrupts.
@@ -139,11 +293,12 @@ thread_start (void) {
 	struct semaphore idle_started;
 	sema_init (&idle_started, 0);
 	thread_create ("idle", PRI_MIN, idle, &idle_started);
+	thread_create ("reaper", PRI_MAX, reaper, NULL);
 
 	/* Start preemptive thread scheduling. */
 	intr_enable ();
 
-	/* Wait for the idle thread to initialize idle_thread. */
+	/* Wait for the idle thread to register with this CPU. */
 	sema_down (&idle_started);
 }
 
@@ -152,27 +307,136 @@ thread_start (void) {
 void
 thread_tick (void) {
 	struct thread *t = thread_current ();
+	struct cpu *cpu = t->cpu;
 
 	/* Update statistics. */
-	if (t == idle_thread)
-		idle_ticks++;
+	if (t == cpu->idle)
+		cpu->idle_ticks++;
 #ifdef USERPROG
 	else if (t->pml4 != NULL)
-		user_ticks++;
+		cpu->user_ticks++;
 #endif
 	else
-		kernel_ticks++;
-		
+		cpu->kernel_ticks++;
+
+	if (thread_mlfqs) {
+		uint64_t start = rdtsc ();
+		uint64_t cycles;
+
+		mlfqs_tick (t);
+		cycles = rdtsc () - start;
+		mlfqs_ticks++;
+		mlfqs_cycles += cycles;
+		if (cycles > mlfqs_cycles_max)
+			mlfqs_cycles_max = cycles;
+	}
+	edf_tick (t);
+
 	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
+	if (++cpu->thread_ticks >= TIME_SLICE)
 		intr_yield_on_return ();
 }
 
 /* Prints thread statistics. */
 void
 thread_print_stats (void) {
-	printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
-			idle_ticks, kernel_ticks, user_ticks);
+	for (int i = 0; i < cpu_cnt; i++) {
+		const struct cpu *cpu = &cpus[i];
+
+		if (cpu_cnt > 1)
+			printf ("CPU %d: ", cpu->id);
+		printf ("Thread: %lld idle ticks, %lld kernel ticks, "
+				"%lld user ticks\n",
+				cpu->idle_ticks, cpu->kernel_ticks, cpu->user_ticks);
+	}
+	printf ("Thread pages: %lld recycled, %lld fresh, %lld reaped\n",
+			pages_recycled, pages_fresh, pages_reaped);
+	if (thread_mlfqs) {
+		printf ("MLFQS: at most %d threads refreshed per %d ticks\n",
+				refresh_max, PRI_REFRESH);
+		if (mlfqs_ticks > 0)
+			printf ("MLFQS: %llu cycles per tick on average, %llu at most\n",
+					mlfqs_cycles / mlfqs_ticks, mlfqs_cycles_max);
+	}
+}
+
+/* Per-thread scheduler counters, copied out of all_list so they
+   can be printed with interrupts on. */
+struct sched_stat {
+	tid_t tid;
+	char name[16];
+	uint64_t run_cycles;
+	uint64_t wait_cycles;
+	unsigned vol_switches;
+	unsigned invol_switches;
+	unsigned donations_received;
+};
+
+/* Prints every thread's scheduler counters and the contents of
+   the context-switch trace ring, in the format read by
+   utils/schedtrace.  Tracing is paused while the ring is
+   printed. */
+void
+thread_dump_sched (void) {
+	struct sched_stat *stats;
+	size_t stat_cnt, i;
+	uint64_t first, last, e;
+
+	spinlock_acquire (&all_lock);
+	stat_cnt = list_size (&all_list);
+	spinlock_release (&all_lock);
+
+	stats = malloc (sizeof *stats * (stat_cnt + 16));
+	if (stats == NULL) {
+		printf ("schedstat: out of memory\n");
+		return;
+	}
+
+	/* Take the snapshot.  Threads created since we counted them
+	   are left out if there is no room. */
+	spinlock_acquire (&all_lock);
+	i = 0;
+	for (struct list_elem *el = list_begin (&all_list);
+			el != list_end (&all_list) && i < stat_cnt + 16;
+			el = list_next (el), i++) {
+		struct thread *t = list_entry (el, struct thread, all_elem);
+		struct sched_stat *s = &stats[i];
+
+		s->tid = t->tid;
+		strlcpy (s->name, t->name, sizeof s->name);
+		s->run_cycles = t->run_cycles;
+		s->wait_cycles = t->wait_cycles;
+		s->vol_switches = t->vol_switches;
+		s->invol_switches = t->invol_switches;
+		s->donations_received = t->donations_received;
+	}
+	stat_cnt = i;
+	spinlock_acquire (&rq_lock);
+	sched_trace_paused = true;
+	last = sched_trace_total;
+	first = last > SCHED_TRACE_CNT ? last - SCHED_TRACE_CNT : 0;
+	spinlock_release (&rq_lock);
+	spinlock_release (&all_lock);
+
+	printf ("SCHED BEGIN %zu %llu\n", stat_cnt, last - first);
+	for (i = 0; i < stat_cnt; i++) {
+		struct sched_stat *s = &stats[i];
+		printf ("SCHED T %d %llu %llu %u %u %u %s\n", s->tid,
+				s->run_cycles, s->wait_cycles, s->vol_switches,
+				s->invol_switches, s->donations_received, s->name);
+	}
+	for (e = first; e < last; e++) {
+		const uint8_t *p = (const uint8_t *) &sched_trace[e % SCHED_TRACE_CNT];
+
+		printf ("SCHED E ");
+		for (i = 0; i < sizeof (struct sched_event); i++)
+			printf ("%02x", p[i]);
+		printf ("\n");
+	}
+	printf ("SCHED END\n");
+
+	sched_trace_paused = false;
+	free (stats);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -200,13 +464,26 @@ thread_create (const char *name, int priority,
 	ASSERT (function != NULL);
 
 	/* Allocate thread. */
-	t = palloc_get_page (PAL_ZERO);
+	t = alloc_thread_page ();
 	if (t == NULL)
 		return TID_ERROR;
 
 	/* Initialize thread. */
 	init_thread (t, name, priority);
 	tid = t->tid = allocate_tid ();
+	spinlock_acquire (&all_lock);
+	list_push_back (&all_list, &t->all_elem);
+	spinlock_release (&all_lock);
+
+	/* Under the MLFQS, the PRIORITY argument is ignored and the
+	   new thread inherits its parent's niceness and recent_cpu.
+	   The idle thread keeps PRI_MIN. */
+	if (thread_mlfqs && function != idle) {
+		t->nice = curr->nice;
+		t->recent_cpu = curr->recent_cpu;
+		mlfqs_update_priority (t);
+		priority = t->priority;
+	}
 
 	/* Call the kernel_thread if it scheduled.
 	 * Note) rdi is 1st argument, and rsi is 2nd argument. */
@@ -217,33 +494,50 @@ thread_create (const char *name, int priority,
 	t->tf.es = SEL_KDSEG;
 	t->tf.ss = SEL_KDSEG;
 	t->tf.cs = SEL_KCSEG;
-	t->tf.eflags = FLAG_IF;
+	/* Start with interrupts off: the thread that switches to us
+	   still holds rq_lock, and kernel_thread() must release it
+	   before anything can interrupt us. */
+	t->tf.eflags = FLAG_MBS;
 
 	/* Add to run queue. */
 	thread_unblock (t); //!
 	//? if문으로 우선순위 판단해서 thread_block 실행
-	if(curr->priority < priority){
-		thread_yield();
-	}
+	test_max_priority ();
 	return tid;
 }
 
-void test_max_priority(void){
+/* Yields the CPU if a ready thread should run before the running
+   thread: an EDF thread with an earlier deadline, or, if the
+   running thread is not in the EDF class, any EDF thread or a
+   thread with a higher priority.  If called from an external
+   interrupt handler, the yield is deferred until the handler
+   returns. */
+void
+test_max_priority (void) {
 	struct thread *curr = thread_current ();
-	struct thread *ready_header;
-
-	if (list_empty(&ready_list)){
-		return;
+	struct heap_elem *e;
+	bool preempt = true;
+
+	spinlock_acquire (&rq_lock);
+	e = heap_min (&edf_ready);
+	if (edf_queued (curr)) {
+		if (e == NULL || !edf_less (e, &curr->edf_elem, NULL))
+			preempt = false;
+	} else if (e == NULL) {
+		/* Mask of all priority levels strictly above ours. */
+		uint64_t above = ~((2ULL << curr->priority) - 1);
+
+		if ((ready_mask & above) == 0)
+			preempt = false;
 	}
+	spinlock_release (&rq_lock);
+	if (!preempt)
+		return;
 
-	ready_header = list_entry(
-		list_begin(&ready_list), 
-		struct thread, elem
-		);
-
-	if(curr->priority < ready_header->priority){
-		thread_yield();
-	}
+	if (intr_context ())
+		intr_yield_on_return ();
+	else
+		thread_preempt ();
 }
 
 // true when a < b
@@ -267,8 +561,10 @@ void
 thread_block (void) {
 	ASSERT (!intr_context ());
 	ASSERT (intr_get_level () == INTR_OFF);
+	spinlock_acquire (&rq_lock);
 	thread_current ()->status = THREAD_BLOCKED;
-	schedule ();
+	schedule (SCHED_BLOCK);
+	spinlock_release (&rq_lock);
 }
 
 /* Transitions a blocked thread T to the ready-to-run state.
@@ -281,20 +577,47 @@ thread_block (void) {
    update other data. */
 void
 thread_unblock (struct thread *t) {
-	enum intr_level old_level;
-
 	ASSERT (is_thread (t));
 
-	old_level = intr_disable ();
+	spinlock_acquire (&rq_lock);
 	ASSERT (t->status == THREAD_BLOCKED);
-	//list_push_back (&ready_list, &t->elem); 
-	//? 정렬한 상태로 푸쉬해야한다!
-	//? 레디큐에 넣어놓고 정렬된 상태에서 
+	ready_push (t);
+	t->status = THREAD_READY;
+	spinlock_release (&rq_lock);
+}
 
-	list_insert_ordered(&ready_list, &t->elem, &cmp_priority, NULL);
+/* Unblocks T, which must be blocked, and switches straight to it
+   if it would be the next thread to run anyway: it has at least
+   the running thread's priority, and no ready thread outranks it.
+   T then runs out the rest of the current time slice, and the
+   running thread goes to the back of its run queue as if it had
+   yielded.  Otherwise, or in an interrupt handler, or if either
+   thread is in the EDF class, this is just thread_unblock().
 
-	t->status = THREAD_READY;
-	intr_set_level (old_level);
+   Interrupts must be off. */
+void
+thread_handoff (struct thread *t) {
+	struct thread *curr = thread_current ();
+	uint64_t above;
+
+	ASSERT (is_thread (t));
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (t->status == THREAD_BLOCKED);
+
+	/* Mask of all priority levels strictly above T's. */
+	above = ~((2ULL << t->priority) - 1);
+	spinlock_acquire (&rq_lock);
+	if (intr_context () || is_idle (curr) || curr->edf || t->edf
+			|| !heap_empty (&edf_ready) || t->priority < curr->priority
+			|| (ready_mask & above) != 0) {
+		ready_push (t);
+		t->status = THREAD_READY;
+	} else {
+		ready_push (curr);
+		curr->status = THREAD_READY;
+		switch_to (t, SCHED_HANDOFF);
+	}
+	spinlock_release (&rq_lock);
 }
 
 /* Returns the name of the running thread. */
@@ -338,9 +661,22 @@ thread_exit (void) {
 #endif
 
 	/* Just set our status to dying and schedule another process.
-	   We will be destroyed during the call to schedule_tail(). */
+	   The thread we switch to recycles our page. */
 	intr_disable ();
-	do_schedule (THREAD_DYING);
+	spinlock_acquire (&all_lock);
+	list_remove (&thread_current ()->all_elem);
+	if (thread_current ()->cpu_dirty)
+		list_remove (&thread_current ()->dirty_elem);
+	spinlock_release (&all_lock);
+	if (thread_current ()->edf)
+		edf_leave (thread_current ());
+
+	/* Our page is about to push the cache over its limit. */
+	if (page_cache_cnt >= THREAD_CACHE_MAX && reaper_thread != NULL
+			&& reaper_thread->status == THREAD_BLOCKED)
+		thread_unblock (reaper_thread);
+	spinlock_acquire (&rq_lock);
+	do_schedule (THREAD_DYING, SCHED_EXIT);
 	NOT_REACHED ();
 }
 
@@ -366,11 +702,11 @@ thread_sleep(int64_t w_tick){
 	ASSERT (!intr_context ());
 
 	old_level = intr_disable ();
-	if (curr != idle_thread)
+	if (!is_idle (curr))
 	{
 		curr->wakeup_tick = w_tick;
 		update_next_tick_to_awake(w_tick);
-		list_push_back (&sleep_list, &curr->elem);
+		heap_insert (&sleep_heap, &curr->sleep_elem);
 		//do_schedule(THREAD_BLOCKED);
 		thread_block();
 	}
@@ -392,33 +728,42 @@ int64_t get_next_tick_to_awake(void)
 	return next_tick_to_awake;
 }
 
-/* sleep list의 모든 entry 를 순회하며 다음과 같은 작업을 수행한다.
-현재 tick이 깨워야 할 tick 보다 크거나 같다면 슬립 큐에서 제거하고 unblock 한다.
-작다면 update_next_tick_to_awake() 를 호출한다.
-*/
-void
-thread_awake(int64_t ticks) {
-	int64_t tmp_tick = INT64_MAX;
-	struct thread* t;
-	for (struct list_elem* e = list_begin(&sleep_list); e != list_end(&sleep_list) ;) {
-			t = list_entry(e, struct thread, elem);
-			ASSERT (is_thread (t));
-			ASSERT (t->status == THREAD_BLOCKED);
-
-			if (ticks >= (t->wakeup_tick)) {
-					e = list_remove(&t->elem);
-					thread_unblock(t);
-					// unblock :: ready로 스레드가 갈거야
-					// next_tick_to_awake야 바뀌어야해
-			}
-			else {
-					if (tmp_tick > t->wakeup_tick)
-						tmp_tick = t->wakeup_tick;
-					e = list_next(e);
-			}
+/* Wakes up sleeping threads whose wakeup_tick is at or before
+   NOW, at most MAX of them, and sets next_tick_to_awake to the
+   earliest remaining wakeup_tick.  Returns the number woken.
+   Only threads that are due are removed; each removal costs
+   O(log n) in the number of sleepers.  Both are in timer clocks
+   (see devices/timer.c).  Interrupts must be off. */
+int
+thread_awake(int64_t now, int max) {
+	struct heap_elem *e;
+	int woken = 0;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	while ((e = heap_min (&sleep_heap)) != NULL && woken < max) {
+		struct thread *t = heap_entry (e, struct thread, sleep_elem);
+		ASSERT (is_thread (t));
+		ASSERT (t->status == THREAD_BLOCKED);
+
+		if (t->wakeup_tick > now)
+			break;
+		heap_pop_min (&sleep_heap);
+		thread_unblock (t);
+		woken++;
 	}
-	next_tick_to_awake = tmp_tick;
-	//printf("#################################\nthread name : %s next_tick_to_awake: %lld\n",t->name, next_tick_to_awake);
+	e = heap_min (&sleep_heap);
+	next_tick_to_awake = e != NULL
+		? heap_entry (e, struct thread, sleep_elem)->wakeup_tick : INT64_MAX;
+	return woken;
+}
+
+/* Orders sleeping threads by wakeup_tick. */
+static bool
+wakeup_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return heap_entry (a, struct thread, sleep_elem)->wakeup_tick
+		< heap_entry (b, struct thread, sleep_elem)->wakeup_tick;
 }
 
 
@@ -426,32 +771,186 @@ thread_awake(int64_t ticks) {
    may be scheduled again immediately at the scheduler's whim. */
 void
 thread_yield (void) {
+	yield (SCHED_YIELD);
+}
+
+/* Like thread_yield(), but for when the running thread is being
+   forced off the CPU, because its time slice expired or a
+   higher-priority thread became ready.  The only difference is
+   how the switch is accounted. */
+void
+thread_preempt (void) {
+	yield (SCHED_PREEMPT);
+}
+
+/* Puts the current thread back on the run queue and schedules,
+   recording REASON for the switch. */
+static void
+yield (enum sched_reason reason) {
 	struct thread *curr = thread_current ();
 	enum intr_level old_level;
 
 	ASSERT (!intr_context ());
 
 	old_level = intr_disable ();
-	if (curr != idle_thread)
-		//list_push_back (&ready_list, &curr->elem); //? sorting 해서 집어넣자.
-		list_insert_ordered(&ready_list, &curr->elem, &cmp_priority, NULL);
-	
-	do_schedule (THREAD_READY);
+	spinlock_acquire (&rq_lock);
+	if (!is_idle (curr))
+		ready_push (curr);
+	do_schedule (THREAD_READY, reason);
+	spinlock_release (&rq_lock);
 	intr_set_level (old_level);
 }
 
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void
 thread_set_priority (int new_priority) {
-	struct thread* curr = thread_current();
-	int old_priority = curr->priority;
-  curr->init_priority = new_priority;
-  refresh_priority(); //나한테 딸려있는 donation list들을 refresh
-	
-  if(old_priority < curr->priority)
-    donate_priority();
-  else
-	  test_max_priority();
+	if (thread_mlfqs)
+		return;
+
+	thread_current ()->init_priority = new_priority;
+	refresh_priority ();
+	test_max_priority ();
+}
+
+/* Sets the current thread's priority to PRIORITY for good, even
+   under the MLFQS, which otherwise ignores thread_set_priority().
+   Meant for kernel service threads, such as workqueue workers,
+   that must not fall behind the threads they serve. */
+void
+thread_set_fixed_priority (int priority) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (priority >= PRI_MIN && priority <= PRI_MAX);
+
+	old_level = intr_disable ();
+	curr->fixed_priority = true;
+	curr->init_priority = priority;
+	change_priority (curr, thread_mlfqs ? priority : effective_priority (curr));
+	intr_set_level (old_level);
+	test_max_priority ();
+}
+
+/* Moves the current thread into the EDF class.  Each PERIOD timer
+   ticks it is given RUNTIME ticks of CPU time, to be used within
+   DEADLINE ticks of the start of the period.  The first period
+   starts now.  Returns false, leaving the thread as it was, if
+   admitting it would reserve more than EDF_BANDWIDTH_MAX of the
+   CPU.  A thread already in the class may call this again to
+   change its parameters. */
+bool
+thread_set_edf (int64_t runtime, int64_t period, int64_t deadline) {
+	struct thread *curr = thread_current ();
+	int64_t now = timer_ticks ();
+	int bandwidth;
+
+	ASSERT (!intr_context ());
+	ASSERT (0 < runtime && runtime <= deadline && deadline <= period);
+
+	/* Admission is by density, runtime / deadline, which is
+	   utilization when the deadline is the period and errs on
+	   the safe side otherwise. */
+	bandwidth = DIV_ROUND_UP (runtime * 1000, deadline);
+
+	spinlock_acquire (&rq_lock);
+	if (edf_bandwidth - curr->edf_bandwidth + bandwidth > EDF_BANDWIDTH_MAX) {
+		spinlock_release (&rq_lock);
+		return false;
+	}
+	edf_bandwidth += bandwidth - curr->edf_bandwidth;
+	if (!curr->edf)
+		list_push_back (&edf_list, &curr->edf_list_elem);
+	curr->edf = true;
+	curr->edf_throttled = false;
+	curr->edf_bandwidth = bandwidth;
+	curr->edf_runtime = runtime;
+	curr->edf_period = period;
+	curr->edf_deadline = deadline;
+	curr->edf_budget = runtime;
+	curr->edf_abs_deadline = now + deadline;
+	curr->edf_release = now + period;
+	spinlock_release (&rq_lock);
+
+	test_max_priority ();
+	return true;
+}
+
+/* Moves the current thread back into the priority class and
+   releases its reserved bandwidth. */
+void
+thread_clear_edf (void) {
+	if (thread_current ()->edf)
+		edf_leave (thread_current ());
+	test_max_priority ();
+}
+
+/* Ends the current EDF job.  A job that ends after its deadline
+   counts as a miss.  Sleeps until the next period starts, unless
+   it already has, and begins the next job there with a full
+   budget. */
+void
+thread_edf_yield (void) {
+	struct thread *curr = thread_current ();
+	int64_t now, release;
+
+	ASSERT (curr->edf);
+
+	spinlock_acquire (&rq_lock);
+	now = timer_ticks ();
+	if (now > curr->edf_abs_deadline)
+		curr->edf_misses++;
+	release = curr->edf_release > now ? curr->edf_release : now;
+	curr->edf_throttled = false;
+	curr->edf_budget = curr->edf_runtime;
+	curr->edf_abs_deadline = release + curr->edf_deadline;
+	curr->edf_release = release + curr->edf_period;
+	spinlock_release (&rq_lock);
+
+	if (release > now)
+		timer_sleep (release - now);
+	else
+		test_max_priority ();
+}
+
+/* Called on every entry into the kernel from user mode, by an
+   interrupt, exception or system call: charges the time since
+   thread_leave_kernel() to the current thread's user time. */
+void
+thread_enter_kernel (void) {
+	struct thread *curr = thread_current ();
+
+	curr->user_cycles += rdtsc () - curr->user_stamp;
+}
+
+/* Called just before the kernel returns to user mode. */
+void
+thread_leave_kernel (void) {
+	thread_current ()->user_stamp = rdtsc ();
+}
+
+/* Stores the current thread's resource usage into RU.  Kernel
+   time is whatever part of its running time was not spent in
+   user mode, so it includes interrupts taken on its behalf. */
+void
+thread_get_rusage (struct rusage *ru) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+	uint64_t run_cycles;
+
+	old_level = intr_disable ();
+	run_cycles = curr->run_cycles + (rdtsc () - curr->run_stamp);
+	ru->utime_cycles = curr->user_cycles;
+	ru->stime_cycles = run_cycles > curr->user_cycles
+		? run_cycles - curr->user_cycles : 0;
+	ru->page_faults = curr->page_faults;
+	ru->disk_reads = curr->disk_reads;
+	ru->disk_writes = curr->disk_writes;
+	ru->vol_switches = curr->vol_switches;
+	ru->invol_switches = curr->invol_switches;
+	intr_set_level (old_level);
+
+	ru->utime_ns = timer_cycles_to_ns (ru->utime_cycles);
+	ru->stime_ns = timer_cycles_to_ns (ru->stime_cycles);
 }
 
 /* Returns the current thread's priority. */
@@ -460,38 +959,140 @@ thread_get_priority (void) {
 	return thread_current ()->priority;
 }
 
-/* Sets the current thread's nice value to NICE. */
+/* Sets the current thread's nice value to NICE and recomputes
+   its priority, yielding if it no longer has the highest
+   priority. */
 void
-thread_set_nice (int nice UNUSED) {
-	/* TODO: Your implementation goes here */
+thread_set_nice (int nice) {
+	enum intr_level old_level;
+
+	ASSERT (NICE_MIN <= nice && nice <= NICE_MAX);
+
+	old_level = intr_disable ();
+	thread_current ()->nice = nice;
+	mlfqs_update_priority (thread_current ());
+	intr_set_level (old_level);
+
+	test_max_priority ();
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return thread_current ()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old_level = intr_disable ();
+	int load_avg_100 = fp_to_int_round (fp_mul_int (load_avg, 100));
+	intr_set_level (old_level);
+	return load_avg_100;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old_level = intr_disable ();
+	int recent_cpu_100 =
+		fp_to_int_round (fp_mul_int (thread_current ()->recent_cpu, 100));
+	intr_set_level (old_level);
+	return recent_cpu_100;
+}
+
+/* Sets T's priority from its recent_cpu and niceness:
+   PRI_MAX - (recent_cpu / 4) - (nice * 2), clamped to the valid
+   range.  The idle thread always stays at PRI_MIN, and threads
+   that called thread_set_fixed_priority() keep their own. */
+static void
+mlfqs_update_priority (struct thread *t) {
+	int priority;
+
+	if (is_idle (t) || t->fixed_priority)
+		return;
+
+	priority = PRI_MAX - fp_to_int (fp_div_int (t->recent_cpu, 4))
+		- t->nice * 2;
+	if (priority < PRI_MIN)
+		priority = PRI_MIN;
+	else if (priority > PRI_MAX)
+		priority = PRI_MAX;
+	thread_requeue (t, priority);
+}
+
+/* MLFQS bookkeeping for one timer tick, with CURR running.
+
+   A thread's priority depends only on its recent_cpu and
+   niceness.  Between the once-per-second decays, recent_cpu only
+   changes for the running thread, so the every-fourth-tick
+   refresh only needs to recompute the threads that ran since the
+   previous refresh; those are kept on dirty_list.  Only the
+   decay touches every thread. */
+static void
+mlfqs_tick (struct thread *curr) {
+	int64_t ticks = timer_ticks ();
+	int touched = 0;
+
+	ASSERT (intr_context ());
+
+	spinlock_acquire (&all_lock);
+	if (!is_idle (curr)) {
+		curr->recent_cpu = fp_add_int (curr->recent_cpu, 1);
+		if (!curr->cpu_dirty) {
+			curr->cpu_dirty = true;
+			list_push_back (&dirty_list, &curr->dirty_elem);
+		}
+	}
+
+	if (ticks % TIMER_FREQ == 0) {
+		/* load_avg = (59/60) * load_avg + (1/60) * ready_threads. */
+		int ready_threads;
+
+		spinlock_acquire (&rq_lock);
+		ready_threads = ready_cnt + !is_idle (curr);
+		spinlock_release (&rq_lock);
+		load_avg = fp_div_int (fp_add_int (fp_mul_int (load_avg, 59),
+					ready_threads), 60);
+
+		/* recent_cpu = (2 * load_avg) / (2 * load_avg + 1) * recent_cpu
+		                + nice, for every thread. */
+		fixed_t twice_load = fp_mul_int (load_avg, 2);
+		fixed_t coef = fp_div (twice_load, fp_add_int (twice_load, 1));
+		for (struct list_elem *e = list_begin (&all_list);
+				e != list_end (&all_list); e = list_next (e)) {
+			struct thread *t = list_entry (e, struct thread, all_elem);
+			t->recent_cpu = fp_add_int (fp_mul (coef, t->recent_cpu), t->nice);
+			mlfqs_update_priority (t);
+		}
+
+		while (!list_empty (&dirty_list))
+			list_entry (list_pop_front (&dirty_list),
+					struct thread, dirty_elem)->cpu_dirty = false;
+	} else if (ticks % PRI_REFRESH == 0) {
+		while (!list_empty (&dirty_list)) {
+			struct thread *t = list_entry (list_pop_front (&dirty_list),
+					struct thread, dirty_elem);
+			t->cpu_dirty = false;
+			mlfqs_update_priority (t);
+			touched++;
+		}
+		if (touched > refresh_max)
+			refresh_max = touched;
+	} else {
+		spinlock_release (&all_lock);
+		return;
+	}
+	spinlock_release (&all_lock);
+
+	test_max_priority ();
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
 
    The idle thread is initially put on the ready list by
    thread_start().  It will be scheduled once initially, at which
-   point it initializes idle_thread, "up"s the semaphore passed
+   point it registers as its CPU's idle thread, "up"s the semaphore passed
    to it to enable thread_start() to continue, and immediately
    blocks.  After that, the idle thread never appears in the
    ready list.  It is returned by next_thread_to_run() as a
@@ -500,7 +1101,7 @@ static void
 idle (void *idle_started_ UNUSED) {
 	struct semaphore *idle_started = idle_started_;
     
-	idle_thread = thread_current ();
+	thread_current ()->cpu->idle = thread_current ();
 	sema_up (idle_started);
 
 	for(;;) {
@@ -508,6 +1109,15 @@ idle (void *idle_started_ UNUSED) {
 		intr_disable ();
 		thread_block ();
 
+		/* Nothing else wants the CPU, so zero some free pages
+		   ahead of time.  Any thread that becomes ready preempts
+		   us between pages as usual. */
+		intr_enable ();
+		while (palloc_zero_idle ())
+			continue;
+		intr_disable ();
+		timer_idle_enter ();
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -526,11 +1136,82 @@ idle (void *idle_started_ UNUSED) {
 	}
 }
 
+/* Returns a page for a new thread, taken from the page cache if
+   possible and from palloc otherwise, or a null pointer if memory
+   is exhausted.  init_thread() clears the struct thread itself;
+   the rest of the page is not zeroed, apart from the top of the
+   stack. */
+static struct thread *
+alloc_thread_page (void) {
+	struct thread *t = NULL;
+
+	spinlock_acquire (&page_cache_lock);
+	if (!list_empty (&page_cache)) {
+		t = list_entry (list_pop_front (&page_cache), struct thread, elem);
+		page_cache_cnt--;
+		pages_recycled++;
+	}
+	spinlock_release (&page_cache_lock);
+
+	if (t == NULL) {
+		t = palloc_get_page (0);
+		if (t == NULL)
+			return NULL;
+		pages_fresh++;
+	}
+	memset ((uint8_t *) t + PGSIZE - STACK_CLEAR, 0, STACK_CLEAR);
+	return t;
+}
+
+/* Reaper thread.  Sleeps until thread_exit() finds the page
+   cache full, then frees the pages beyond THREAD_CACHE_MAX,
+   oldest first, with interrupts on.
+
+   It runs at PRI_MAX, even under the MLFQS, because the cache
+   only overflows while threads are exiting, usually under load:
+   at a low priority it would not get the CPU until the load
+   was gone, and the excess pages would stay out of palloc's
+   reach all that time.  Its work is short and bounded by the
+   number of threads that exited. */
+static void
+reaper (void *aux UNUSED) {
+	reaper_thread = thread_current ();
+	thread_set_fixed_priority (PRI_MAX);
+
+	for (;;) {
+		struct list victims;
+		enum intr_level old_level;
+
+		list_init (&victims);
+		old_level = intr_disable ();
+		spinlock_acquire (&page_cache_lock);
+		while (page_cache_cnt > THREAD_CACHE_MAX) {
+			list_push_back (&victims, list_pop_back (&page_cache));
+			page_cache_cnt--;
+		}
+		spinlock_release (&page_cache_lock);
+		if (list_empty (&victims))
+			thread_block ();
+		intr_set_level (old_level);
+
+		while (!list_empty (&victims)) {
+			struct thread *t =
+				list_entry (list_pop_front (&victims), struct thread, elem);
+			palloc_free_page (t);
+			pages_reaped++;
+		}
+	}
+}
+
 /* Function used as the basis for a kernel thread. */
 static void
 kernel_thread (thread_func *function, void *aux) {
 	ASSERT (function != NULL);
 
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	switch_finish ();     /* Finish the switch that started us. */
+	spinlock_release (&rq_lock);  /* Taken by the thread that did. */
 	intr_enable ();       /* The scheduler runs with interrupts off. */
 	function (aux);       /* Execute the thread function. */
 	thread_exit ();       /* If function() returns, kill the thread. */
@@ -538,7 +1219,7 @@ kernel_thread (thread_func *function, void *aux) {
 
 
 /* Does basic initialization of T as a blocked thread named
-   NAME. */
+   NAME.  The caller adds it to all_list. */
 static void
 init_thread (struct thread *t, const char *name, int priority) {
 	ASSERT (t != NULL);
@@ -554,20 +1235,102 @@ init_thread (struct thread *t, const char *name, int priority) {
 	
 	t->init_priority = priority;
 	t->wait_on_lock = NULL;
-	list_init(&t->donations);
+	t->wait_on_rwlock = NULL;
+	list_init(&t->held_locks);
+	list_init (&t->ceiling_locks);
+	t->wait_ceiling = PRI_MIN;
+
+	t->nice = NICE_DEFAULT;
+	t->recent_cpu = 0;
 }
 
 /* Chooses and returns the next thread to be scheduled.  Should
    return a thread from the run queue, unless the run queue is
    empty.  (If the running thread can continue running, then it
    will be in the run queue.)  If the run queue is empty, return
-   idle_thread. */
+   the running CPU's idle thread.  rq_lock must be held. */
 static struct thread *
 next_thread_to_run (void) {
-	if (list_empty (&ready_list))
-		return idle_thread;
-	else
-		return list_entry (list_pop_front (&ready_list), struct thread, elem);
+	struct thread *t;
+
+	ASSERT (spinlock_held (&rq_lock));
+
+	if (!heap_empty (&edf_ready)) {
+		t = heap_entry (heap_min (&edf_ready), struct thread, edf_elem);
+		ready_remove (t);
+		return t;
+	}
+	if (ready_mask == 0)
+		return this_cpu ()->idle;
+
+	t = list_entry (list_front (&ready_queues[bsrq (ready_mask)]),
+			struct thread, elem);
+	ready_remove (t);
+	return t;
+}
+
+/* Appends T to the tail of the run queue for its priority, or
+   adds it to the EDF run queue if it is an unthrottled EDF
+   thread.  rq_lock must be held. */
+static void
+ready_push (struct thread *t) {
+	ASSERT (spinlock_held (&rq_lock));
+
+	if (edf_queued (t)) {
+		heap_insert (&edf_ready, &t->edf_elem);
+		ready_cnt++;
+		t->ready_stamp = rdtsc ();
+		return;
+	}
+	list_push_back (&ready_queues[t->priority], &t->elem);
+	ready_mask |= 1ULL << t->priority;
+	ready_cnt++;
+	t->ready_stamp = rdtsc ();
+}
+
+/* Removes T from the run queue for its priority.  T's priority
+   and EDF state must not have changed since ready_push().
+   rq_lock must be held. */
+static void
+ready_remove (struct thread *t) {
+	ASSERT (spinlock_held (&rq_lock));
+
+	if (edf_queued (t)) {
+		heap_remove (&edf_ready, &t->edf_elem);
+		ready_cnt--;
+		return;
+	}
+	list_remove (&t->elem);
+	if (list_empty (&ready_queues[t->priority]))
+		ready_mask &= ~(1ULL << t->priority);
+	ready_cnt--;
+}
+
+/* Sets T's priority to PRIORITY.  If T is in the run queue, it
+   moves to the tail of the queue for its new priority.  If T is
+   in a wait queue, it moves behind the waiters of its new
+   priority there. */
+static void
+thread_requeue (struct thread *t, int priority) {
+	enum intr_level old_level = intr_disable ();
+	struct waitq *waitq = t->waitq;
+
+	/* A thread in cond_wait() can be in a wait queue and ready at
+	   once, so handle both. */
+	if (t->priority != priority) {
+		spinlock_acquire (&rq_lock);
+		if (t->status == THREAD_READY)
+			ready_remove (t);
+		if (waitq != NULL)
+			waitq_remove (waitq, t);
+		t->priority = priority;
+		if (waitq != NULL)
+			waitq_push (waitq, t);
+		if (t->status == THREAD_READY)
+			ready_push (t);
+		spinlock_release (&rq_lock);
+	}
+	intr_set_level (old_level);
 }
 
 /* Use iretq to launch the thread */
@@ -598,106 +1361,89 @@ do_iret (struct intr_frame *tf) {
 			: : "g" ((uint64_t) tf) : "memory");
 }
 
-/* Switching the thread by activating the new thread's page
-   tables, and, if the previous thread is dying, destroying it.
-
-   At this function's invocation, we just switched from thread
-   PREV, the new thread is already running, and interrupts are
-   still disabled.
-
-   It's not safe to call printf() until the thread switch is
-   complete.  In practice that means that printf()s should be
-   added at the end of the function. */
-	 //curr thread
-static void
-thread_launch (struct thread *th) {
-	uint64_t tf_cur = (uint64_t) &running_thread ()->tf;
-	uint64_t tf = (uint64_t) &th->tf;
-	ASSERT (intr_get_level () == INTR_OFF);
-
-	/* The main switching logic.
-	 * We first restore the whole execution context into the intr_frame
-	 * and then switching to the next thread by calling do_iret.
-	 * Note that, we SHOULD NOT use any stack from here
-	 * until switching is done. */
-	__asm __volatile (
-			/* Store registers that will be used. */
-			"push %%rax\n"
-			"push %%rbx\n"
-			"push %%rcx\n"
-			/* Fetch input once */
-			"movq %0, %%rax\n"
-			"movq %1, %%rcx\n"
-			"movq %%r15, 0(%%rax)\n"
-			"movq %%r14, 8(%%rax)\n"
-			"movq %%r13, 16(%%rax)\n"
-			"movq %%r12, 24(%%rax)\n"
-			"movq %%r11, 32(%%rax)\n"
-			"movq %%r10, 40(%%rax)\n"
-			"movq %%r9, 48(%%rax)\n"
-			"movq %%r8, 56(%%rax)\n"
-			"movq %%rsi, 64(%%rax)\n"
-			"movq %%rdi, 72(%%rax)\n"
-			"movq %%rbp, 80(%%rax)\n"
-			"movq %%rdx, 88(%%rax)\n"
-			"pop %%rbx\n"              // Saved rcx
-			"movq %%rbx, 96(%%rax)\n"
-			"pop %%rbx\n"              // Saved rbx
-			"movq %%rbx, 104(%%rax)\n"
-			"pop %%rbx\n"              // Saved rax
-			"movq %%rbx, 112(%%rax)\n"
-			"addq $120, %%rax\n"
-			"movw %%es, (%%rax)\n"
-			"movw %%ds, 8(%%rax)\n"
-			"addq $32, %%rax\n"
-			"call __next\n"         // read the current rip.
-			"__next:\n"
-			"pop %%rbx\n"
-			"addq $(out_iret -  __next), %%rbx\n"
-			"movq %%rbx, 0(%%rax)\n" // rip
-			"movw %%cs, 8(%%rax)\n"  // cs
-			"pushfq\n"
-			"popq %%rbx\n"
-			"mov %%rbx, 16(%%rax)\n" // eflags
-			"mov %%rsp, 24(%%rax)\n" // rsp
-			"movw %%ss, 32(%%rax)\n"
-			"mov %%rcx, %%rdi\n"
-			"call do_iret\n"
-			"out_iret:\n"
-			: : "g"(tf_cur), "g" (tf) : "memory"
-			);
-}
-
-/* Schedules a new process. At entry, interrupts must be off.
+/* Schedules a new process. At entry, interrupts must be off and
+ * rq_lock held.
  * This function modify current thread's status to status and then
  * finds another thread to run and switches to it.
  * It's not safe to call printf() in the schedule(). */
 static void
-do_schedule(int status) {
+do_schedule(int status, enum sched_reason reason) {
 	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (spinlock_held (&rq_lock));
 	ASSERT (thread_current()->status == THREAD_RUNNING);
-	while (!list_empty (&destruction_req)) {
-		struct thread *victim =
-			list_entry (list_pop_front (&destruction_req), struct thread, elem);
-		palloc_free_page(victim);
-	}
 	thread_current()->status = status;
-	schedule ();
+	schedule (reason);
+}
+
+/* Charges the switch from CURR to NEXT, for REASON, to both
+   threads' counters and records it in the trace ring.  NEXT's
+   status has not been changed yet. */
+static void
+account_switch (struct thread *curr, struct thread *next,
+		enum sched_reason reason) {
+	uint64_t now = rdtsc ();
+	uint64_t wait = 0;
+
+	curr->run_cycles += now - curr->run_stamp;
+	if (reason == SCHED_PREEMPT)
+		curr->invol_switches++;
+	else
+		curr->vol_switches++;
+
+	if (next->status == THREAD_READY) {
+		wait = now - next->ready_stamp;
+		next->wait_cycles += wait;
+	}
+	next->run_stamp = now;
+
+	if (!sched_trace_paused) {
+		struct sched_event *ev =
+			&sched_trace[sched_trace_total++ % SCHED_TRACE_CNT];
+		ev->tsc = now;
+		ev->wait = wait;
+		ev->prev = curr->tid;
+		ev->next = next->tid;
+		ev->reason = reason;
+		ev->prev_priority = curr->priority;
+		ev->next_priority = next->priority;
+	}
+}
+
+static void
+schedule (enum sched_reason reason) {
+	switch_to (next_thread_to_run (), reason);
 }
 
+/* Switches from the running thread, whose status has already been
+   changed, to NEXT, which is not in the run queue.  rq_lock must
+   be held, and no other spin lock.  It is still held when the
+   thread that switched to us returns here, and our caller
+   releases it. */
 static void
-schedule (void) {
+switch_to (struct thread *next, enum sched_reason reason) {
 	struct thread *curr = running_thread ();
-	struct thread *next = next_thread_to_run ();
+	struct cpu *cpu = curr->cpu;
 
 	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (spinlock_held (&rq_lock));
+	ASSERT (cpu->lock_depth == 1);
 	ASSERT (curr->status != THREAD_RUNNING);
 	ASSERT (is_thread (next));
-	/* Mark us as running. */
+	if (curr != next)
+		account_switch (curr, next, reason);
+
+	/* Mark us as running, on this CPU. */
 	next->status = THREAD_RUNNING;
+	next->cpu = cpu;
 	
-	/* Start new time slice. */
-	thread_ticks = 0;
+	/* Start new time slice, unless NEXT takes over the rest of
+	   ours. */
+	if (reason != SCHED_HANDOFF)
+		cpu->thread_ticks = 0;
+
+	/* Catch up on any ticks that went by while idle. */
+	if (curr == cpu->idle && next != cpu->idle)
+		cpu->idle_ticks += timer_idle_exit ();
 
 #ifdef USERPROG
 	/* Activate the new address space. */
@@ -705,23 +1451,132 @@ schedule (void) {
 #endif
 	//curr이 idle이고, ready함수가 비어있을 때 if문 안으로 들어가지 못한다!
 	if (curr != next) {
-		/* If the thread we switched from is dying, destroy its struct
-		   thread. This must happen late so that thread_exit() doesn't
-		   pull out the rug under itself.
-		   We just queuing the page free reqeust here because the page is
-		   currently used bye the stack.
-		   The real destruction logic will be called at the beginning of the
-		   schedule(). */
+		/* If the thread we switched from is dying, the thread we
+		   switch to recycles its page, in switch_finish().  It
+		   cannot go on the cache any earlier, because it is our
+		   stack until the switch below, and another CPU could
+		   take it off the cache as soon as it is there. */
 			 //initial_thread = main thread
-		if (curr && curr->status == THREAD_DYING && curr != initial_thread) {
-			ASSERT (curr != next);
-			list_push_back (&destruction_req, &curr->elem);
+		if (curr->status == THREAD_DYING && curr != initial_thread)
+			cpu->dying = curr;
+
+		/* Save our callee-saved registers and stack pointer, then
+		   resume NEXT where it switched out, or launch it through
+		   its intr_frame if it has never run. */
+		switch_threads (&curr->switch_rsp, next->switch_rsp, &next->tf);
+		switch_finish ();
+	}
+}
+
+/* Completes a switch to the running thread, which has just been
+   resumed or launched by switch_to(): recycles the page of the
+   thread it switched from, if that thread was dying.  rq_lock
+   must be held. */
+static void
+switch_finish (void) {
+	struct cpu *cpu = this_cpu ();
+	struct thread *dying = cpu->dying;
+
+	ASSERT (spinlock_held (&rq_lock));
+
+	if (dying != NULL) {
+		cpu->dying = NULL;
+		spinlock_acquire (&page_cache_lock);
+		list_push_front (&page_cache, &dying->elem);
+		page_cache_cnt++;
+		spinlock_release (&page_cache_lock);
+	}
+}
+
+/* Returns the CPU the caller is running on.  The answer can be
+   stale as soon as it is returned unless interrupts are off,
+   because a preempted thread may resume on another CPU. */
+struct cpu *
+this_cpu (void) {
+	return running_thread ()->cpu;
+}
+
+/* Returns true if T is scheduled by the EDF class right now. */
+static bool
+edf_queued (const struct thread *t) {
+	return t->edf && !t->edf_throttled;
+}
+
+/* Orders EDF threads by absolute deadline. */
+static bool
+edf_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return heap_entry (a, struct thread, edf_elem)->edf_abs_deadline
+		< heap_entry (b, struct thread, edf_elem)->edf_abs_deadline;
+}
+
+/* Charges the current tick to CURR's EDF budget, throttling it
+   if the budget runs out, and replenishes throttled threads
+   whose next period has started.  Called from thread_tick(). */
+static void
+edf_tick (struct thread *curr) {
+	int64_t now;
+
+	ASSERT (intr_context ());
+
+	spinlock_acquire (&rq_lock);
+	if (edf_queued (curr) && --curr->edf_budget <= 0) {
+		curr->edf_throttled = true;
+		curr->edf_overruns++;
+		if (curr->edf_release < edf_next_release)
+			edf_next_release = curr->edf_release;
+		intr_yield_on_return ();
+	}
+
+	now = timer_ticks ();
+	if (now < edf_next_release) {
+		spinlock_release (&rq_lock);
+		return;
+	}
+
+	/* Give each throttled thread whose period has started a new
+	   job, and move it back into the EDF run queue. */
+	edf_next_release = INT64_MAX;
+	for (struct list_elem *e = list_begin (&edf_list);
+			e != list_end (&edf_list); e = list_next (e)) {
+		struct thread *t = list_entry (e, struct thread, edf_list_elem);
+
+		if (!t->edf_throttled)
+			continue;
+		if (t->edf_release > now) {
+			if (t->edf_release < edf_next_release)
+				edf_next_release = t->edf_release;
+			continue;
 		}
 
-		/* Before switching the thread, we first save the information
-		 * of current running. */
-		thread_launch (next);
+		if (t->status == THREAD_READY)
+			ready_remove (t);
+		t->edf_throttled = false;
+		t->edf_budget = t->edf_runtime;
+		t->edf_abs_deadline = t->edf_release + t->edf_deadline;
+		t->edf_release += t->edf_period;
+		if (t->status == THREAD_READY)
+			ready_push (t);
 	}
+	spinlock_release (&rq_lock);
+	test_max_priority ();
+}
+
+/* Takes T out of the EDF class. */
+static void
+edf_leave (struct thread *t) {
+	spinlock_acquire (&rq_lock);
+	ASSERT (t->edf);
+
+	if (t->status == THREAD_READY)
+		ready_remove (t);
+	list_remove (&t->edf_list_elem);
+	edf_bandwidth -= t->edf_bandwidth;
+	t->edf = false;
+	t->edf_bandwidth = 0;
+	if (t->status == THREAD_READY)
+		ready_push (t);
+	spinlock_release (&rq_lock);
 }
 
 /* Returns a tid to use for a new thread. */
@@ -737,86 +1592,131 @@ allocate_tid (void) {
 	return tid;
 }
 
-/* priority donation 을 수행하는 함수를 구현한다.
-현재 스레드가 기다리고 있는 lock 과 연결 된 모든 스레드들을 순회하며
-현재 스레드의 우선순위를 lock 을 보유하고 있는 스레드에게 기부 한다.
-(Nested donation 그림 참고, nested depth 는 8로 제한한다. ) */
-void donate_priority(void){
-  struct thread* curr = thread_current(); // pri 6
-  if(curr->wait_on_lock == NULL){
-    return;
-  }
-	struct thread* next = curr->wait_on_lock->holder; // main 6
-	int nested_depth = 0;
-
-	while (next != NULL){
-		if(next->priority < curr->priority)
-			next->priority = curr->priority;
-    if(next->wait_on_lock == NULL)
-      break;
-		next = next->wait_on_lock->holder;
+/* Returns T's effective priority: its own priority, raised to
+   that of the highest-priority thread waiting on any lock it
+   holds, and to that of any writer waiting for it to release a
+   reader-writer lock.  Each lock keeps its waiters in a max-heap,
+   so this only looks at the top of one heap per held lock. */
+static int
+effective_priority (struct thread *t) {
+	int priority = t->init_priority;
+
+	for (struct list_elem *e = list_begin (&t->held_locks);
+			e != list_end (&t->held_locks); e = list_next (e)) {
+		struct lock *lock = list_entry (e, struct lock, elem);
+		struct heap_elem *top = heap_min (&lock->donors);
+
+		if (top != NULL) {
+			struct thread *donor = heap_entry (top, struct thread, donor_elem);
+			if (donor->priority > priority)
+				priority = donor->priority;
+		}
 	}
+	for (struct list_elem *e = list_begin (&t->ceiling_locks);
+			e != list_end (&t->ceiling_locks); e = list_next (e)) {
+		struct ceiling_lock *cl = list_entry (e, struct ceiling_lock, elem);
 
+		if (cl->ceiling > priority)
+			priority = cl->ceiling;
+	}
+	if (t->wait_ceiling > priority)
+		priority = t->wait_ceiling;
+	for (int i = 0; i < RWLOCK_READ_MAX; i++) {
+		struct rwlock *rw = t->read_holds[i].rwlock;
 
+		if (rw != NULL && rw->drainer != NULL && rw->drainer->priority > priority)
+			priority = rw->drainer->priority;
+	}
+	return priority;
+}
 
-	// struct thread* curr = thread_current(); // pri 6
-	// struct thread* next = curr->wait_on_lock->holder; // main 6
-	// int nested_depth = 0;
-
-	// while (next != NULL){
-	// 	if(next->priority >= curr->priority)
-	// 		break;
-	// 	next->priority = curr->priority;
-
-	// 	next = next->wait_on_lock->holder;
-	// }
+/* Changes T's priority to PRIORITY, moving it within the run
+   queue or the donor heap of the lock it waits on, so that both
+   stay ordered. */
+static void
+change_priority (struct thread *t, int priority) {
+	struct heap *donors = NULL;
+
+	/* A thread that sema_up() has just woken is still in the heap
+	   until it runs again, so check for that even if T is ready. */
+	if (t->wait_on_lock != NULL)
+		donors = &t->wait_on_lock->donors;
+
+	if (donors != NULL)
+		heap_remove (donors, &t->donor_elem);
+	thread_requeue (t, priority);
+	if (donors != NULL)
+		heap_insert (donors, &t->donor_elem);
 }
 
-/* lock 을 해지 했을때 donations 리스트에서 해당 엔트리를
-삭제 하기 위한 함수를 구현한다. */
-void remove_with_lock(struct lock *lock){
-	struct thread* curr = thread_current();
-	struct thread* t;
-  
-  if(list_empty(&curr->donations)){
-    return;
-  }
+/* Raises or lowers T to its effective priority.  Returns false
+   if its priority did not change. */
+static bool
+update_priority (struct thread *t) {
+	int priority = effective_priority (t);
+
+	if (priority == t->priority)
+		return false;
+	if (priority > t->priority)
+		t->donations_received++;
+	change_priority (t, priority);
+	return true;
+}
 
-	for (struct list_elem* e = list_begin(&curr->donations); e != list_end(&curr->donations) ;) {
-		t = list_entry(e, struct thread, donation_elem);
-		ASSERT (is_thread (t));
-		if (t->wait_on_lock == lock){
-			e = list_remove(&t->donation_elem);
-		}
-		else{
-			e = list_next(e);
-		}
+/* Does the work of donate_priority(), passing the change through
+   at most DEPTH more threads.  A writer waiting for readers hands
+   its priority to every one of them, so this recurses once per
+   reader there. */
+static void
+donate_from (struct thread *t, int depth) {
+	for (; depth > 0; depth--) {
+		if (t->wait_on_lock != NULL) {
+			struct thread *holder = t->wait_on_lock->holder;
+
+			if (holder == NULL || !update_priority (holder))
+				break;
+			t = holder;
+		} else if (t->wait_on_rwlock != NULL) {
+			struct list *holds = &t->wait_on_rwlock->holds;
+
+			for (struct list_elem *e = list_begin (holds); e != list_end (holds);
+					e = list_next (e)) {
+				struct thread *reader =
+					list_entry (e, struct rwlock_hold, elem)->thread;
+
+				if (update_priority (reader))
+					donate_from (reader, depth - 1);
+			}
+			break;
+		} else
+			break;
 	}
 }
 
-/* 현재 스레드의 우선순위를 기부받기 전의 우선순위로 변경 */
-/* 가장 우선수위가 높은 donations 리스트의 스레드와
-현재 스레드의 우선순위를 비교하여 높은 값을 현재 스레드의
-우선순위로 설정한다. */
-void refresh_priority(void){
-	struct thread* curr = thread_current();
-	struct thread* t;
-
-	curr->priority = curr->init_priority;
-  
-  if(!list_empty(&curr->donations)){
-	  list_sort(&curr->donations, &cmp_priority, NULL);
-    int list_priority = list_entry(list_begin(&curr->donations), struct thread, donation_elem)->priority;
-    if (list_priority > curr->priority)
-      curr->priority = list_priority;
-  }
+/* Passes a change in T's priority on to the holder of the lock T
+   waits on, or to the readers of the rwlock T waits to write, and
+   from there along the chain of lock holders, until
+   a holder's effective priority stays the same or donate_depth
+   holders have been updated.  T must already be in its lock's
+   donor heap with its new priority. */
+void
+donate_priority (struct thread *t) {
+	enum intr_level old_level = intr_disable ();
 
+	donate_from (t, donate_depth);
+	intr_set_level (old_level);
+}
 
-	// for (struct list_elem* e = list_begin(&curr->donations); e!=list_end(&curr->donations); e=list_next(e)) {
-	// 	t = list_entry(e, struct thread, donation_elem);
-	// 	ASSERT(is_thread(t));
+/* Recomputes the current thread's priority from its own priority
+   and the locks it holds.  The running thread can still be in a
+   wait queue, as in cond_wait(), which queues it before releasing
+   the lock, so the change goes through change_priority() to keep
+   that queue ordered. */
+void
+refresh_priority (void) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level = intr_disable ();
 
-	// 	if (t->priority > curr->priority)
-	// 		curr->priority = t->priority;
-	// }
-}
\ No newline at end of file
+	change_priority (curr, effective_priority (curr));
+	intr_set_level (old_level);
+}
@@ -0,0 +1,140 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* The workqueue that interrupt handlers use by default. */
+struct workqueue system_wq;
+
+/* See workqueue.h. */
+bool workqueue_bypass;
+
+/* Number of worker threads in the system workqueue. */
+#define SYSTEM_WORKERS 2
+
+/* A worker thread's startup information. */
+struct worker_start {
+	struct workqueue *wq;       /* Queue to serve. */
+	int priority;               /* Priority to run at. */
+	struct semaphore started;   /* Upped once the worker has copied us. */
+};
+
+static thread_func worker;
+
+/* Creates the system workqueue.  Must be called after
+   thread_start(), since it creates threads.  Work queued before
+   then is run at once by work_queue(). */
+void
+workqueue_init (void) {
+	workqueue_create (&system_wq, "events", WQ_PRI_DEFAULT, SYSTEM_WORKERS);
+}
+
+/* Initializes WQ and starts WORKER_CNT threads named after NAME
+   to run its work at PRIORITY.  The workers keep PRIORITY even
+   under the MLFQS. */
+void
+workqueue_create (struct workqueue *wq, const char *name,
+		int priority, int worker_cnt) {
+	ASSERT (wq != NULL);
+	ASSERT (priority >= PRI_MIN && priority <= PRI_MAX);
+	ASSERT (worker_cnt > 0);
+
+	wq->name = name;
+	list_init (&wq->items);
+	sema_init (&wq->ready, 0);
+	wq->worker_cnt = 0;
+	wq->run_cnt = 0;
+	wq->merge_cnt = 0;
+
+	for (int i = 0; i < worker_cnt; i++) {
+		struct worker_start start;
+		char thread_name[16];
+
+		start.wq = wq;
+		start.priority = priority;
+		sema_init (&start.started, 0);
+		snprintf (thread_name, sizeof thread_name, "%s/%d", name, i);
+		if (thread_create (thread_name, priority, worker, &start) == TID_ERROR)
+			PANIC ("%s: cannot create worker thread", name);
+		sema_down (&start.started);
+	}
+}
+
+/* Prints statistics for the system workqueue. */
+void
+workqueue_print_stats (void) {
+	printf ("Workqueue %s: %lld items run, %lld requests merged\n",
+			system_wq.name != NULL ? system_wq.name : "events",
+			system_wq.run_cnt, system_wq.merge_cnt);
+}
+
+/* Initializes W to call FUNC, which can find AUX in W->aux. */
+void
+work_init (struct work *w, work_func *func, void *aux) {
+	ASSERT (w != NULL);
+	ASSERT (func != NULL);
+
+	w->func = func;
+	w->aux = aux;
+	w->pending = false;
+}
+
+/* Queues W on WQ and returns true, or returns false if W is
+   already pending.  May be called from an interrupt handler.
+   Until WQ has a worker, and while workqueue_bypass is set, runs
+   W immediately instead. */
+bool
+work_queue (struct workqueue *wq, struct work *w) {
+	enum intr_level old_level;
+	bool queued = false;
+
+	ASSERT (wq != NULL);
+	ASSERT (w != NULL);
+
+	if (wq->worker_cnt == 0 || workqueue_bypass) {
+		w->func (w);
+		return true;
+	}
+
+	old_level = intr_disable ();
+	if (!w->pending) {
+		w->pending = true;
+		list_push_back (&wq->items, &w->elem);
+		queued = true;
+	} else
+		wq->merge_cnt++;
+	intr_set_level (old_level);
+
+	if (queued)
+		sema_up (&wq->ready);
+	return queued;
+}
+
+/* Worker thread.  Runs the queue's work, oldest first, one item
+   at a time. */
+static void
+worker (void *start_) {
+	struct worker_start *start = start_;
+	struct workqueue *wq = start->wq;
+	enum intr_level old_level;
+
+	thread_set_fixed_priority (start->priority);
+	old_level = intr_disable ();
+	wq->worker_cnt++;
+	intr_set_level (old_level);
+	sema_up (&start->started);
+
+	for (;;) {
+		struct work *w;
+
+		sema_down (&wq->ready);
+		old_level = intr_disable ();
+		w = list_entry (list_pop_front (&wq->items), struct work, elem);
+		w->pending = false;
+		wq->run_cnt++;
+		intr_set_level (old_level);
+
+		w->func (w);
+	}
+}
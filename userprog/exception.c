@@ -133,7 +133,7 @@ page_fault (struct intr_frame *f) {
 	/* Turn interrupts back on (they were only off so that we could
 	   be assured of reading CR2 before it changed). */
 	intr_enable ();
-
+	thread_current ()->page_faults++;
 
 	/* Determine cause. */
 	not_present = (f->error_code & PF_P) == 0;
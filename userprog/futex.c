@@ -0,0 +1,123 @@
+#include "userprog/futex.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
+#include "threads/mmu.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Fast user-space mutexes.
+ *
+ * A user program keeps its lock word in its own memory and
+ * changes it with atomic instructions, entering the kernel only
+ * to sleep while the word holds a value that means "contended"
+ * (futex_wait()) or to wake sleepers after changing it
+ * (futex_wake()).  The kernel knows nothing about what the values
+ * mean.
+ *
+ * A waiter is keyed by the kernel virtual address of the word,
+ * which identifies the physical frame and offset it lives in.
+ * That way two processes that map the same frame, through a
+ * shared mapping, wait on the same queue, whatever the user
+ * addresses they use.
+ *
+ * Every operation runs with interrupts off, which is what makes
+ * checking the word and going to sleep atomic with respect to a
+ * wake. */
+
+/* Number of hash buckets for waiters. */
+#define FUTEX_BUCKETS 64
+
+/* A thread sleeping in futex_wait().  Lives on its kernel
+   stack. */
+struct futex_waiter {
+	const int *key;             /* Kernel address of the word. */
+	struct semaphore sema;      /* Upped to wake the thread. */
+	struct list_elem elem;      /* Element in a bucket. */
+};
+
+static struct list buckets[FUTEX_BUCKETS];
+
+static const int *futex_key (int *uaddr);
+static struct list *bucket_of (const int *key);
+
+/* Initializes the futex wait queues. */
+void
+futex_init (void) {
+	for (int i = 0; i < FUTEX_BUCKETS; i++)
+		list_init (&buckets[i]);
+}
+
+/* If the word at user address UADDR still holds EXPECTED, sleeps
+   until futex_wake() is called on the same word and returns 0.
+   Otherwise returns 1 at once, so that the caller can look at the
+   word again.  Returns -1 if UADDR is misaligned or not mapped. */
+int
+futex_wait (int *uaddr, int expected) {
+	struct futex_waiter w;
+	enum intr_level old_level;
+
+	w.key = futex_key (uaddr);
+	if (w.key == NULL)
+		return -1;
+
+	old_level = intr_disable ();
+	if (*w.key != expected) {
+		intr_set_level (old_level);
+		return 1;
+	}
+	sema_init (&w.sema, 0);
+	list_push_back (bucket_of (w.key), &w.elem);
+	sema_down (&w.sema);
+	intr_set_level (old_level);
+	return 0;
+}
+
+/* Wakes up to N threads waiting on the word at user address
+   UADDR, oldest first, and returns how many it woke.  Returns -1
+   if UADDR is misaligned or not mapped. */
+int
+futex_wake (int *uaddr, int n) {
+	const int *key = futex_key (uaddr);
+	struct list *bucket;
+	enum intr_level old_level;
+	int woken = 0;
+
+	if (key == NULL)
+		return -1;
+
+	bucket = bucket_of (key);
+	old_level = intr_disable ();
+	for (struct list_elem *e = list_begin (bucket);
+			e != list_end (bucket) && woken < n;) {
+		struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+
+		e = list_next (e);
+		if (w->key == key) {
+			list_remove (&w->elem);
+			sema_up (&w->sema);
+			woken++;
+		}
+	}
+	intr_set_level (old_level);
+	return woken;
+}
+
+/* Returns the kernel address of the int at user address UADDR,
+   or a null pointer if UADDR is not aligned, is not a user
+   address, or is not mapped in the current process. */
+static const int *
+futex_key (int *uaddr) {
+	if ((uintptr_t) uaddr % sizeof *uaddr != 0 || !is_user_vaddr (uaddr))
+		return NULL;
+	return pml4_get_page (thread_current ()->pml4, uaddr);
+}
+
+/* Returns the bucket for waiters on KEY. */
+static struct list *
+bucket_of (const int *key) {
+	return &buckets[hash_int ((int) ((uintptr_t) key >> 2)) % FUTEX_BUCKETS];
+}
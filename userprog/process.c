@@ -152,8 +152,10 @@ __do_fork (void *aux) {
 	process_init ();
 
 	/* Finally, switch to the newly created process. */
-	if (succ)
+	if (succ) {
+		thread_leave_kernel ();
 		do_iret (&if_);
+	}
 error:
 	thread_exit ();
 }
@@ -185,6 +187,7 @@ process_exec (void *f_name) {
 		return -1;
 
 	/* Start switched process. */
+	thread_leave_kernel ();
 	do_iret (&_if);
 	NOT_REACHED ();
 }
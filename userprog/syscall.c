@@ -1,15 +1,23 @@
 #include "userprog/syscall.h"
+#include <rusage.h>
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "threads/loader.h"
+#include "threads/mmu.h"
+#include "threads/vaddr.h"
+#include "userprog/futex.h"
 #include "userprog/gdt.h"
 #include "threads/flags.h"
 #include "intrinsic.h"
 
 void syscall_entry (void);
 void syscall_handler (struct intr_frame *);
+static int sys_futex (int *uaddr, int op, int val);
+static int sys_getrusage (struct rusage *uru);
+static bool copy_out (void *udst, const void *src, size_t size);
 
 /* System call.
  *
@@ -35,12 +43,81 @@ syscall_init (void) {
 	 * mode stack. Therefore, we masked the FLAG_FL. */
 	write_msr(MSR_SYSCALL_MASK,
 			FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
+
+	futex_init ();
 }
 
 /* The main system call interface */
 void
-syscall_handler (struct intr_frame *f UNUSED) {
-	// TODO: Your implementation goes here.
-	printf ("system call!\n");
-	thread_exit ();
+syscall_handler (struct intr_frame *f) {
+	thread_enter_kernel ();
+	switch (f->R.rax) {
+		case SYS_FUTEX:
+			f->R.rax = sys_futex ((int *) f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+		case SYS_GETRUSAGE:
+			f->R.rax = sys_getrusage ((struct rusage *) f->R.rdi);
+			break;
+		default:
+			// TODO: Your implementation goes here.
+			printf ("system call!\n");
+			thread_exit ();
+	}
+	thread_leave_kernel ();
+}
+
+/* futex (UADDR, OP, VAL).  See userprog/futex.c. */
+static int
+sys_futex (int *uaddr, int op, int val) {
+	switch (op) {
+		case FUTEX_WAIT:
+			return futex_wait (uaddr, val);
+		case FUTEX_WAKE:
+			return futex_wake (uaddr, val);
+		default:
+			return -1;
+	}
+}
+
+/* getrusage (URU).  Copies the calling process's resource usage
+   to URU.  Returns 0 if successful, -1 if URU is not writable. */
+static int
+sys_getrusage (struct rusage *uru) {
+	struct rusage ru;
+
+	thread_get_rusage (&ru);
+	return copy_out (uru, &ru, sizeof ru) ? 0 : -1;
+}
+
+/* Copies SIZE bytes from SRC to user address UDST.  Returns
+   false, having copied nothing, unless every page UDST spans is a
+   user page mapped writable in the current process. */
+static bool
+copy_out (void *udst, const void *src, size_t size) {
+	uint64_t *pml4 = thread_current ()->pml4;
+	uint8_t *dst = udst;
+	uint8_t *page;
+
+	if (size == 0)
+		return true;
+	for (page = pg_round_down (dst); page < dst + size; page += PGSIZE) {
+		uint64_t *pte;
+
+		if (!is_user_vaddr (page))
+			return false;
+		pte = pml4e_walk (pml4, (uint64_t) page, 0);
+		if (pte == NULL || !(*pte & PTE_P) || !is_writable (pte))
+			return false;
+	}
+
+	while (size > 0) {
+		size_t ofs = pg_ofs (dst);
+		size_t chunk = PGSIZE - ofs < size ? PGSIZE - ofs : size;
+
+		memcpy (pml4_get_page (pml4, dst), src, chunk);
+		dst += chunk;
+		src = (const uint8_t *) src + chunk;
+		size -= chunk;
+	}
+	return true;
 }